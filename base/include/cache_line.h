@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_CACHE_LINE_H
+#define UTILS_BASE_CACHE_LINE_H
+
+#include <cstddef>
+
+namespace OHOS {
+
+// alignment that keeps data written by different threads off the same cache line
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+} // namespace OHOS
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_CONCURRENT_HASH_MAP_H
+#define UTILS_BASE_CONCURRENT_HASH_MAP_H
+
+#include "cache_line.h"
+#include "nocopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace OHOS {
+
+/*
+ * Hash map with the interface of SafeMap for large tables shared by many threads.
+ *
+ * Keys are spread over a power-of-two number of shards, each one an unordered_map
+ * behind its own reader-writer lock, so threads only contend when they touch the same
+ * shard and lookups of one shard run in parallel. The shard is chosen from the high
+ * bits of the multiplied hash, leaving the low bits to the buckets inside the shard.
+ *
+ * Callbacks run with the lock of the shard held and must not call back into the map.
+ * Size, IsEmpty, Clear and Iterate visit the shards one after another, they are not
+ * atomic with respect to writers on other shards.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class ConcurrentHashMap : public NoCopyable {
+public:
+    static constexpr size_t DEFAULT_SHARD_NUM = 64;
+
+    // shardNum is rounded up to a power of two
+    explicit ConcurrentHashMap(size_t shardNum = DEFAULT_SHARD_NUM)
+        : mask_(RoundUpShardNum(shardNum) - 1), shards_(new Shard[mask_ + 1])
+    {
+    }
+
+    ~ConcurrentHashMap() {}
+
+    // reserve buckets for count entries in total, avoids rehashing while the table grows
+    void Reserve(size_t count)
+    {
+        size_t perShard = count / (mask_ + 1) + 1;
+        for (size_t i = 0; i <= mask_; ++i) {
+            std::unique_lock<std::shared_mutex> lock(shards_[i].mutex);
+            shards_[i].map.reserve(perShard);
+        }
+    }
+
+    // when multithread calling Size() return a tmp status, some threads may insert just after Size() call
+    int Size()
+    {
+        size_t size = 0;
+        for (size_t i = 0; i <= mask_; ++i) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+            size += shards_[i].map.size();
+        }
+        return static_cast<int>(size);
+    }
+
+    // when multithread calling IsEmpty() return a tmp status, some threads may insert just after IsEmpty() call
+    bool IsEmpty()
+    {
+        for (size_t i = 0; i <= mask_; ++i) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+            if (!shards_[i].map.empty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Insert(const K& key, const V& value)
+    {
+        Shard& shard = ShardOf(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.emplace(key, value).second;
+    }
+
+    void EnsureInsert(const K& key, const V& value)
+    {
+        Shard& shard = ShardOf(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.map.insert_or_assign(key, value);
+    }
+
+    bool Find(const K& key, V& value)
+    {
+        Shard& shard = ShardOf(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto iter = shard.map.find(key);
+        if (iter == shard.map.end()) {
+            return false;
+        }
+        value = iter->second;
+        return true;
+    }
+
+    bool FindOldAndSetNew(const K& key, V& oldValue, const V& newValue)
+    {
+        Shard& shard = ShardOf(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto iter = shard.map.find(key);
+        if (iter == shard.map.end()) {
+            return false;
+        }
+        oldValue = iter->second;
+        iter->second = newValue;
+        return true;
+    }
+
+    void Erase(const K& key)
+    {
+        Shard& shard = ShardOf(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.map.erase(key);
+    }
+
+    void Clear()
+    {
+        for (size_t i = 0; i <= mask_; ++i) {
+            std::unique_lock<std::shared_mutex> lock(shards_[i].mutex);
+            shards_[i].map.clear();
+        }
+    }
+
+    /*
+     * return the value of key, compute(key) is called to insert it if absent.
+     * compute runs at most once per absent key, even if several threads ask for it at the same time.
+     */
+    template <typename Computer>
+    V ComputeIfAbsent(const K& key, Computer&& compute)
+    {
+        Shard& shard = ShardOf(key);
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto iter = shard.map.find(key);
+            if (iter != shard.map.end()) {
+                return iter->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto iter = shard.map.find(key);
+        if (iter == shard.map.end()) {
+            iter = shard.map.emplace(key, compute(key)).first;
+        }
+        return iter->second;
+    }
+
+    // call update(value) on the value of key in place, return false if key is absent
+    template <typename Updater>
+    bool Update(const K& key, Updater&& update)
+    {
+        Shard& shard = ShardOf(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto iter = shard.map.find(key);
+        if (iter == shard.map.end()) {
+            return false;
+        }
+        update(iter->second);
+        return true;
+    }
+
+    using ConcurrentHashMapCallBack = std::function<void(const K, V&)>;
+
+    // entries are visited shard by shard in no particular order
+    void Iterate(const ConcurrentHashMapCallBack& callback)
+    {
+        for (size_t i = 0; i <= mask_; ++i) {
+            std::unique_lock<std::shared_mutex> lock(shards_[i].mutex);
+            for (auto& entry : shards_[i].map) {
+                callback(entry.first, entry.second);
+            }
+        }
+    }
+
+    size_t GetShardNum() const
+    {
+        return mask_ + 1;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<K, V, Hash, KeyEqual> map;
+    };
+
+    static size_t RoundUpShardNum(size_t shardNum)
+    {
+        size_t size = 1;
+        while (size < shardNum) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    Shard& ShardOf(const K& key)
+    {
+        constexpr uint64_t goldenRatio = 0x9E3779B97F4A7C15ULL;
+        constexpr int highBits = 32; // 32: the high half of the product depends on every bit of the hash
+        uint64_t mixed = static_cast<uint64_t>(hasher_(key)) * goldenRatio;
+        return shards_[static_cast<size_t>(mixed >> highBits) & mask_];
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Shard[]> shards_;
+    Hash hasher_;
+};
+
+} // namespace OHOS
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_LATENCY_HISTOGRAM_H
+#define UTILS_BASE_LATENCY_HISTOGRAM_H
+
+#include "nocopyable.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace OHOS {
+
+/*
+ * Lock-free histogram with log2 buckets, it can be recorded and read from any thread.
+ * bucket 0 counts value 0, bucket i counts values in [2^(i-1), 2^i),
+ * the last bucket also counts every larger value.
+ * Readings are not a consistent snapshot while other threads keep recording.
+ */
+class LatencyHistogram : public NoCopyable {
+public:
+    static constexpr size_t BUCKET_NUM = 64;
+
+    LatencyHistogram()
+    {
+        Reset();
+    }
+
+    ~LatencyHistogram() {}
+
+    void Record(uint64_t value)
+    {
+        buckets_[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while ((value > max) && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t GetCount() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t GetSum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t GetMax() const { return max_.load(std::memory_order_relaxed); }
+
+    uint64_t GetBucketCount(size_t index) const
+    {
+        return (index < BUCKET_NUM) ? buckets_[index].load(std::memory_order_relaxed) : 0;
+    }
+
+    // largest value counted by bucket index, the last bucket is unbounded
+    static uint64_t GetBucketUpperBound(size_t index)
+    {
+        if (index == 0) {
+            return 0;
+        }
+        if (index >= BUCKET_NUM - 1) {
+            return UINT64_MAX;
+        }
+        return (static_cast<uint64_t>(1) << index) - 1;
+    }
+
+    /*
+     * percent: range (0, 100]
+     * return the upper bound of the bucket holding the percentile, capped by the max value recorded.
+     */
+    uint64_t GetPercentile(double percent) const
+    {
+        uint64_t count = GetCount();
+        if ((count == 0) || (percent <= 0)) {
+            return 0;
+        }
+
+        uint64_t rank = static_cast<uint64_t>(std::ceil(count * percent / 100)); // 100: percent to ratio
+        if (rank == 0) {
+            rank = 1;
+        }
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_NUM; ++i) {
+            seen += GetBucketCount(i);
+            if (seen >= rank) {
+                uint64_t bound = GetBucketUpperBound(i);
+                uint64_t max = GetMax();
+                return (bound < max) ? bound : max;
+            }
+        }
+        return GetMax();
+    }
+
+    void Reset()
+    {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static size_t BucketOf(uint64_t value)
+    {
+        if (value == 0) {
+            return 0;
+        }
+        size_t index = 64 - static_cast<size_t>(__builtin_clzll(value)); // 64: bits of uint64_t
+        return (index < BUCKET_NUM) ? index : (BUCKET_NUM - 1);
+    }
+
+    std::atomic<uint64_t> buckets_[BUCKET_NUM];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+} // namespace OHOS
+
+#endif
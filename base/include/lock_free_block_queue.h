@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_LOCK_FREE_BLOCK_QUEUE_H
+#define UTILS_BASE_LOCK_FREE_BLOCK_QUEUE_H
+
+#include "cache_line.h"
+#include "nocopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+namespace OHOS {
+
+/*
+ * Bounded multi-producer multi-consumer queue with the interface of SafeBlockQueue.
+ *
+ * The ring has a power-of-two number of slots, capacity is rounded up. Each slot
+ * carries a sequence number telling whether it is ready to be written or read
+ * (D. Vyukov's bounded MPMC queue), so PushNoWait and PopNotWait never take a lock.
+ * Push and Pop only sleep on a futex when the queue is full or empty, and the
+ * other side only issues a wake-up syscall when someone sleeps.
+ */
+template <typename T>
+class LockFreeBlockQueue : public NoCopyable {
+public:
+    explicit LockFreeBlockQueue(int capacity)
+        : mask_(RoundUpCapacity(capacity) - 1), cells_(new Cell[mask_ + 1])
+    {
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        head_.pos.store(0, std::memory_order_relaxed);
+        tail_.pos.store(0, std::memory_order_relaxed);
+    }
+
+    ~LockFreeBlockQueue()
+    {
+        size_t pos = head_.pos.load(std::memory_order_relaxed);
+        size_t tail = tail_.pos.load(std::memory_order_relaxed);
+        for (; pos != tail; ++pos) {
+            reinterpret_cast<T*>(&cells_[pos & mask_].storage)->~T();
+        }
+    }
+
+    void Push(T const& elem)
+    {
+        while (!PushNoWait(elem)) {
+            Wait(notFull_, [this] { return IsFull(); });
+        }
+    }
+
+    T Pop()
+    {
+        size_t pos = 0;
+        Cell* cell = nullptr;
+        while ((cell = AcquireReadCell(pos)) == nullptr) {
+            Wait(notEmpty_, [this] { return IsEmpty(); });
+        }
+
+        T* elem = reinterpret_cast<T*>(&cell->storage);
+        T out(std::move(*elem));
+        ReleaseReadCell(cell, pos);
+        return out;
+    }
+
+    bool PushNoWait(T const& elem)
+    {
+        size_t pos = tail_.pos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // the slot still holds the element of the previous lap, full
+            } else {
+                pos = tail_.pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (&cell->storage) T(elem);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        Notify(notEmpty_);
+        return true;
+    }
+
+    bool PopNotWait(T& outtask)
+    {
+        size_t pos = 0;
+        Cell* cell = AcquireReadCell(pos);
+        if (cell == nullptr) {
+            return false;
+        }
+
+        outtask = std::move(*reinterpret_cast<T*>(&cell->storage));
+        ReleaseReadCell(cell, pos);
+        return true;
+    }
+
+    // a tmp status when called with other threads pushing or popping
+    unsigned int Size()
+    {
+        size_t head = head_.pos.load(std::memory_order_acquire);
+        size_t tail = tail_.pos.load(std::memory_order_acquire);
+        return (tail > head) ? static_cast<unsigned int>(tail - head) : 0;
+    }
+
+    bool IsEmpty()
+    {
+        return Size() == 0;
+    }
+
+    bool IsFull()
+    {
+        return Size() >= Capacity();
+    }
+
+    size_t Capacity() const
+    {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Position {
+        std::atomic<size_t> pos;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) WaitWord {
+        std::atomic<uint32_t> seq {0};  // futex word, changes on every wake-up
+        std::atomic<uint32_t> waiters {0};
+    };
+
+    // claim the oldest written slot, nullptr if empty
+    Cell* AcquireReadCell(size_t& pos)
+    {
+        pos = head_.pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell* cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return cell;
+                }
+            } else if (diff < 0) {
+                return nullptr; // the slot is not written yet, empty
+            } else {
+                pos = head_.pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // destroy the element moved out and hand the slot to the producer of the next lap
+    void ReleaseReadCell(Cell* cell, size_t pos)
+    {
+        reinterpret_cast<T*>(&cell->storage)->~T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        Notify(notFull_);
+    }
+
+    static size_t RoundUpCapacity(int capacity)
+    {
+        size_t size = 1;
+        while (static_cast<int64_t>(size) < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    static long Futex(std::atomic<uint32_t>& word, int op, uint32_t value)
+    {
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), op, value, nullptr, nullptr, 0);
+    }
+
+    /*
+     * The word is read before the condition, a Notify in between makes FUTEX_WAIT return at once.
+     * The fences pair with the one in Notify: either the waiter sees the change of the queue,
+     * or the notifier sees the waiter.
+     */
+    template <typename Condition>
+    static void Wait(WaitWord& word, Condition blocked)
+    {
+        uint32_t seq = word.seq.load(std::memory_order_acquire);
+        word.waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (blocked()) {
+            Futex(word.seq, FUTEX_WAIT_PRIVATE, seq);
+        }
+        word.waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // no syscall and no write to the shared word unless someone sleeps
+    static void Notify(WaitWord& word)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (word.waiters.load(std::memory_order_relaxed) > 0) {
+            word.seq.fetch_add(1, std::memory_order_release);
+            Futex(word.seq, FUTEX_WAKE_PRIVATE, 1);
+        }
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    Position head_;
+    Position tail_;
+    WaitWord notEmpty_;
+    WaitWord notFull_;
+};
+
+} // namespace OHOS
+
+#endif
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_PARALLEL_ALGORITHM_H
+#define UTILS_BASE_PARALLEL_ALGORITHM_H
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace OHOS {
+
+/*
+ * Loop parallelization on a ThreadPool.
+ *
+ * The range is cut into chunks claimed dynamically by the calling thread and
+ * by helper tasks added to the pool with AddInternalTask. Chunks shrink as the range
+ * drains (guided scheduling), never below the grain. The caller always takes
+ * part and only waits for chunks other threads are already running, so these
+ * functions may be called from a task of the same pool, and still complete if
+ * the pool is full or has not been started.
+ * If func throws, the chunks not started yet are skipped and the first exception
+ * is rethrown in the calling thread once the running chunks have finished.
+ */
+namespace ParallelDetail {
+
+// chunks per participant at the smallest default grain
+constexpr size_t DEFAULT_CHUNKS_PER_THREAD = 64;
+// below this size ParallelSort sorts in the calling thread
+constexpr size_t SORT_SEQUENTIAL_THRESHOLD = 4096;
+
+class ChunkScheduler {
+public:
+    using ChunkFunc = std::function<void(size_t chunkBegin, size_t chunkEnd)>;
+
+    ChunkScheduler(size_t begin, size_t end, size_t grain, size_t participants, const ChunkFunc& func)
+        : end_(end), total_(end - begin), grain_(grain), participants_(participants), next_(begin), done_(0),
+          func_(func)
+    {
+    }
+
+    // run chunks until none is left to claim
+    void Work()
+    {
+        size_t chunkBegin = 0;
+        size_t chunkEnd = 0;
+        while (Claim(chunkBegin, chunkEnd)) {
+            // after a failure the chunks left are only counted, so WaitAllDone still returns
+            if (!failed_.load()) {
+                Run(chunkBegin, chunkEnd);
+            }
+            Finish(chunkEnd - chunkBegin);
+        }
+    }
+
+    // rethrow the first exception of func, in the calling thread
+    void WaitAllDone()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        allDone_.wait(lock, [this] { return done_.load() == total_; });
+        if (exception_ != nullptr) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+private:
+    // never lets an exception reach a pool worker or leave chunks uncounted, built without exceptions func can't throw
+    void Run(size_t chunkBegin, size_t chunkEnd)
+    {
+#ifdef __cpp_exceptions
+        try {
+            func_(chunkBegin, chunkEnd);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (exception_ == nullptr) {
+                exception_ = std::current_exception();
+            }
+            failed_.store(true);
+        }
+#else
+        func_(chunkBegin, chunkEnd);
+#endif
+    }
+
+    bool Claim(size_t& chunkBegin, size_t& chunkEnd)
+    {
+        size_t current = next_.load();
+        while (current < end_) {
+            size_t remaining = end_ - current;
+            size_t chunk = std::min(remaining, std::max(grain_, remaining / (2 * participants_))); // 2: guided
+            if (next_.compare_exchange_weak(current, current + chunk)) {
+                chunkBegin = current;
+                chunkEnd = current + chunk;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Finish(size_t count)
+    {
+        if (done_.fetch_add(count) + count == total_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            allDone_.notify_all();
+        }
+    }
+
+    const size_t end_;
+    const size_t total_;
+    const size_t grain_;
+    const size_t participants_;
+    std::atomic<size_t> next_;
+    std::atomic<size_t> done_;
+    std::atomic<bool> failed_ {false};
+    std::exception_ptr exception_;  // guarded by mutex_
+    ChunkFunc func_;
+    std::mutex mutex_;
+    std::condition_variable allDone_;
+};
+
+/*
+ * grain: minimum indexes per chunk, 0 means chosen from the range size and the pool size.
+ */
+inline void ParallelChunks(ThreadPool& pool, size_t begin, size_t end, size_t grain,
+    const ChunkScheduler::ChunkFunc& func)
+{
+    if (begin >= end) {
+        return;
+    }
+
+    size_t total = end - begin;
+    size_t participants = pool.GetThreadsNum() + 1;
+    if (grain == 0) {
+        grain = std::max<size_t>(1, total / (participants * DEFAULT_CHUNKS_PER_THREAD));
+    }
+    if ((participants == 1) || (total <= grain)) {
+        func(begin, end);
+        return;
+    }
+
+    // helpers hold the scheduler, one that starts after the loop has finished finds nothing to claim
+    auto scheduler = std::make_shared<ChunkScheduler>(begin, end, grain, participants, func);
+    size_t helpers = std::min(participants - 1, (total + grain - 1) / grain - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        // a full pool refuses helpers without discarding user tasks or counting rejections
+        if (!pool.AddInternalTask([scheduler] { scheduler->Work(); }, false)) {
+            break;
+        }
+    }
+
+    scheduler->Work();
+    scheduler->WaitAllDone();
+}
+
+} // namespace ParallelDetail
+
+/*
+ * call func(index) for every index in [begin, end).
+ */
+template <typename Func>
+void ParallelFor(ThreadPool& pool, size_t begin, size_t end, const Func& func, size_t grain = 0)
+{
+    ParallelDetail::ParallelChunks(pool, begin, end, grain, [&func](size_t chunkBegin, size_t chunkEnd) {
+        for (size_t index = chunkBegin; index < chunkEnd; ++index) {
+            func(index);
+        }
+    });
+}
+
+/*
+ * reduce(...reduce(reduce(identity, func(begin)), func(begin + 1))..., func(end - 1)).
+ * reduce must be associative and identity its neutral element, the order of the indexes is kept.
+ */
+template <typename T, typename Func, typename Reduce>
+T ParallelReduce(ThreadPool& pool, size_t begin, size_t end, const T& identity, const Func& func,
+    const Reduce& reduce, size_t grain = 0)
+{
+    std::mutex mutex;
+    std::vector<std::pair<size_t, T>> partials;
+    ParallelDetail::ParallelChunks(pool, begin, end, grain,
+        [&identity, &func, &reduce, &mutex, &partials](size_t chunkBegin, size_t chunkEnd) {
+            T partial = identity;
+            for (size_t index = chunkBegin; index < chunkEnd; ++index) {
+                partial = reduce(std::move(partial), func(index));
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            partials.emplace_back(chunkBegin, std::move(partial));
+        });
+
+    std::sort(partials.begin(), partials.end(),
+        [](const std::pair<size_t, T>& lhs, const std::pair<size_t, T>& rhs) { return lhs.first < rhs.first; });
+    T result = identity;
+    for (auto& partial : partials) {
+        result = reduce(std::move(result), std::move(partial.second));
+    }
+    return result;
+}
+
+/*
+ * sort [first, last) by blocks in parallel, then merge the blocks pairwise, one parallel round per level.
+ * not stable.
+ */
+template <typename RandomIt, typename Compare>
+void ParallelSort(ThreadPool& pool, RandomIt first, RandomIt last, Compare comp)
+{
+    size_t total = static_cast<size_t>(std::distance(first, last));
+    size_t blocks = pool.GetThreadsNum() + 1;
+    if ((total <= ParallelDetail::SORT_SEQUENTIAL_THRESHOLD) || (blocks == 1)) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    size_t blockSize = (total + blocks - 1) / blocks;
+    blocks = (total + blockSize - 1) / blockSize;
+    ParallelFor(pool, 0, blocks, [first, total, blockSize, &comp](size_t block) {
+        size_t lower = block * blockSize;
+        size_t upper = std::min(total, lower + blockSize);
+        std::sort(first + lower, first + upper, comp);
+    }, 1);
+
+    for (size_t width = blockSize; width < total; width *= 2) { // 2: merge two sorted runs into one
+        size_t pairs = (total + 2 * width - 1) / (2 * width); // 2: merge two sorted runs into one
+        ParallelFor(pool, 0, pairs, [first, total, width, &comp](size_t pair) {
+            size_t lower = pair * 2 * width; // 2: merge two sorted runs into one
+            size_t middle = std::min(total, lower + width);
+            size_t upper = std::min(total, middle + width);
+            if (middle < upper) {
+                std::inplace_merge(first + lower, first + middle, first + upper, comp);
+            }
+        }, 1);
+    }
+}
+
+template <typename RandomIt>
+void ParallelSort(ThreadPool& pool, RandomIt first, RandomIt last)
+{
+    ParallelSort(pool, first, last, std::less<typename std::iterator_traits<RandomIt>::value_type>());
+}
+
+} // namespace OHOS
+
+#endif
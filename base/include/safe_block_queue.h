@@ -16,14 +16,27 @@
 #ifndef UTILS_BASE_BLOCK_QUEUE_H
 #define UTILS_BASE_BLOCK_QUEUE_H
 
+#include <algorithm>
+#include <chrono>
 #include <climits>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
+#include <thread>
 #include <atomic>
 
 namespace OHOS {
 
+/*
+ * A waiting thread first gives the lock away and yields a few times before it sleeps on
+ * the condition variable, the number of rounds grows while spinning pays off and shrinks
+ * when the thread ends up sleeping anyway. The waiters counted per condition let the other
+ * side skip the notification when nobody sleeps, and it is sent after the lock is released
+ * so the woken thread does not block on it again.
+ *
+ * After Close, pushes fail and blocked threads are woken up, the elements left can still
+ * be popped. Pop on a closed and drained queue returns T(), PopFor tells it by returning false.
+ */
 template <typename T>
 class SafeBlockQueue {
 public:
@@ -31,43 +44,46 @@ public:
     {
     }
 
+    // the element is dropped if the queue is closed
     virtual void Push(T const& elem)
     {
         std::unique_lock<std::mutex> lock(mutexLock_);
-        while (queueT_.size() >= maxSize_) {
-            // queue full , waiting for jobs to be taken
-            cvNotFull_.wait(lock, [&]() { return (queueT_.size() < maxSize_); });
+        // queue full , waiting for jobs to be taken
+        WaitNotFull(lock, NO_DEADLINE);
+        if (closed_) {
+            return;
         }
 
         // here means not full we can push in
         queueT_.push(elem);
-        cvNotEmpty_.notify_one();
+        NotifyNotEmpty(lock);
     }
 
+    // returns T() once the queue is closed and drained, use PopFor when T() may be a valid element
     T Pop()
     {
         std::unique_lock<std::mutex> lock(mutexLock_);
-
-        while (queueT_.empty()) {
-            // queue empty, waiting for tasks to be Push
-            cvNotEmpty_.wait(lock, [&] { return !queueT_.empty(); });
+        // queue empty, waiting for tasks to be Push
+        WaitNotEmpty(lock, NO_DEADLINE);
+        if (queueT_.empty()) {
+            return T(); // closed and drained
         }
 
-        T elem = queueT_.front();
+        T elem = std::move(queueT_.front());
         queueT_.pop();
-        cvNotFull_.notify_one();
+        NotifyNotFull(lock);
         return elem;
     }
 
     virtual bool PushNoWait(T const& elem)
     {
         std::unique_lock<std::mutex> lock(mutexLock_);
-        if (queueT_.size() >= maxSize_) {
+        if (closed_ || (queueT_.size() >= maxSize_)) {
             return false;
         }
         // here means not full we can push in
         queueT_.push(elem);
-        cvNotEmpty_.notify_one();
+        NotifyNotEmpty(lock);
         return true;
     }
 
@@ -77,14 +93,54 @@ public:
         if (queueT_.empty()) {
             return false;
         }
-        outtask = queueT_.front();
+        outtask = std::move(queueT_.front());
         queueT_.pop();
 
-        cvNotFull_.notify_one();
+        NotifyNotFull(lock);
+
+        return true;
+    }
+
+    // false if still full after timeout or the queue is closed
+    virtual bool PushFor(T const& elem, const std::chrono::milliseconds& timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutexLock_);
+        if (!WaitNotFull(lock, DeadlineAfter(timeout)) || closed_) {
+            return false;
+        }
+        queueT_.push(elem);
+        NotifyNotEmpty(lock);
+        return true;
+    }
 
+    // false if still empty after timeout or the queue is closed and drained
+    bool PopFor(T& outtask, const std::chrono::milliseconds& timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutexLock_);
+        if (!WaitNotEmpty(lock, DeadlineAfter(timeout)) || queueT_.empty()) {
+            return false;
+        }
+        outtask = std::move(queueT_.front());
+        queueT_.pop();
+        NotifyNotFull(lock);
         return true;
     }
 
+    virtual void Close()
+    {
+        std::unique_lock<std::mutex> lock(mutexLock_);
+        closed_ = true;
+        lock.unlock();
+        cvNotEmpty_.notify_all();
+        cvNotFull_.notify_all();
+    }
+
+    bool IsClosed()
+    {
+        std::unique_lock<std::mutex> lock(mutexLock_);
+        return closed_;
+    }
+
     unsigned int Size()
     {
         std::unique_lock<std::mutex> lock(mutexLock_);
@@ -106,13 +162,100 @@ public:
     virtual ~SafeBlockQueue() {}
 
 protected:
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    static constexpr Deadline NO_DEADLINE = Deadline::max();
+    static constexpr unsigned int MIN_SPIN_ROUNDS = 1;
+    static constexpr unsigned int MAX_SPIN_ROUNDS = 64;
+
+    // timeout from now, a timeout beyond the range of the clock, e.g. milliseconds::max(), never expires
+    static Deadline DeadlineAfter(const std::chrono::milliseconds& timeout)
+    {
+        Deadline now = std::chrono::steady_clock::now();
+        if (timeout >= std::chrono::duration_cast<std::chrono::milliseconds>(NO_DEADLINE - now)) {
+            return NO_DEADLINE;
+        }
+        return now + timeout;
+    }
+
+    // return false if the deadline passed with the queue still full and open
+    bool WaitNotFull(std::unique_lock<std::mutex>& lock, Deadline deadline)
+    {
+        return WaitUntil(lock, cvNotFull_, notFullWaiters_, deadline,
+            [this] { return closed_ || (queueT_.size() < maxSize_); });
+    }
+
+    // return false if the deadline passed with the queue still empty and open
+    bool WaitNotEmpty(std::unique_lock<std::mutex>& lock, Deadline deadline)
+    {
+        return WaitUntil(lock, cvNotEmpty_, notEmptyWaiters_, deadline,
+            [this] { return closed_ || !queueT_.empty(); });
+    }
+
+    // called with lock held, returns with it released
+    void NotifyNotEmpty(std::unique_lock<std::mutex>& lock)
+    {
+        NotifyOne(lock, cvNotEmpty_, notEmptyWaiters_);
+    }
+
+    void NotifyNotFull(std::unique_lock<std::mutex>& lock)
+    {
+        NotifyOne(lock, cvNotFull_, notFullWaiters_);
+    }
+
+    template <typename Predicate>
+    bool WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& cv, unsigned int& waiters,
+        Deadline deadline, Predicate ready)
+    {
+        if (ready()) {
+            return true;
+        }
+
+        unsigned int rounds = spinRounds_;
+        for (unsigned int i = 0; i < rounds; ++i) {
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+            if (ready()) {
+                spinRounds_ = std::min(MAX_SPIN_ROUNDS, spinRounds_ * 2); // 2: spinning paid off, try longer
+                return true;
+            }
+        }
+        spinRounds_ = std::max(MIN_SPIN_ROUNDS, spinRounds_ / 2); // 2: spinning was wasted, try shorter
+
+        bool result = true;
+        ++waiters;
+        if (deadline == NO_DEADLINE) {
+            cv.wait(lock, ready);
+        } else {
+            result = cv.wait_until(lock, deadline, ready);
+        }
+        --waiters;
+        return result;
+    }
+
+    static void NotifyOne(std::unique_lock<std::mutex>& lock, std::condition_variable& cv, unsigned int waiters)
+    {
+        lock.unlock();
+        if (waiters > 0) {
+            cv.notify_one();
+        }
+    }
+
     unsigned long maxSize_;
     std::mutex mutexLock_;
     std::condition_variable cvNotEmpty_;
     std::condition_variable cvNotFull_;
     std::queue<T> queueT_;
+    bool closed_ = false;
+    unsigned int notEmptyWaiters_ = 0;
+    unsigned int notFullWaiters_ = 0;
+    unsigned int spinRounds_ = MIN_SPIN_ROUNDS;
 };
 
+/*
+ * Join and JoinFor also return once the queue is closed, without waiting for the tasks left.
+ */
 template <typename T>
 class SafeBlockQueueTracking : public SafeBlockQueue<T> {
 public:
@@ -127,30 +270,51 @@ public:
     {
         unfinishedTaskCount_++;
         std::unique_lock<std::mutex> lock(mutexLock_);
-        while (queueT_.size() >= maxSize_) {
-            // queue full , waiting for jobs to be taken
-            cvNotFull_.wait(lock, [&]() { return (queueT_.size() < maxSize_); });
+        // queue full , waiting for jobs to be taken
+        this->WaitNotFull(lock, SafeBlockQueue<T>::NO_DEADLINE);
+        if (closed_) {
+            unfinishedTaskCount_--; // dropped, Join has already been woken up by Close
+            return;
         }
 
         // here means not full we can push in
         queueT_.push(elem);
 
-        cvNotEmpty_.notify_one();
+        this->NotifyNotEmpty(lock);
     }
 
     virtual bool PushNoWait(T const& elem)
     {
         std::unique_lock<std::mutex> lock(mutexLock_);
-        if (queueT_.size() >= maxSize_) {
+        if (closed_ || (queueT_.size() >= maxSize_)) {
             return false;
         }
         // here means not full we can push in
         queueT_.push(elem);
         unfinishedTaskCount_++;
-        cvNotEmpty_.notify_one();
+        this->NotifyNotEmpty(lock);
+        return true;
+    }
+
+    virtual bool PushFor(T const& elem, const std::chrono::milliseconds& timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutexLock_);
+        if (!this->WaitNotFull(lock, this->DeadlineAfter(timeout)) || closed_) {
+            return false;
+        }
+        queueT_.push(elem);
+        unfinishedTaskCount_++;
+        this->NotifyNotEmpty(lock);
         return true;
     }
 
+    virtual void Close()
+    {
+        SafeBlockQueue<T>::Close();
+        std::unique_lock<std::mutex> lock(mutexLock_);
+        cvAllTasksDone_.notify_all();
+    }
+
     bool OneTaskDone()
     {
         std::unique_lock<std::mutex> lock(mutexLock_);
@@ -170,7 +334,21 @@ public:
     void Join()
     {
         std::unique_lock<std::mutex> lock(mutexLock_);
-        cvAllTasksDone_.wait(lock, [&] { return unfinishedTaskCount_ == 0; });
+        cvAllTasksDone_.wait(lock, [&] { return (unfinishedTaskCount_ == 0) || closed_; });
+    }
+
+    // true if all tasks are done before timeout
+    bool JoinFor(const std::chrono::milliseconds& timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutexLock_);
+        auto done = [&] { return (unfinishedTaskCount_ == 0) || closed_; };
+        auto deadline = this->DeadlineAfter(timeout);
+        if (deadline == this->NO_DEADLINE) {
+            cvAllTasksDone_.wait(lock, done);
+        } else {
+            cvAllTasksDone_.wait_until(lock, deadline, done);
+        }
+        return unfinishedTaskCount_ == 0;
     }
 
     int GetUnfinishTaskNum()
@@ -184,6 +362,7 @@ protected:
     using SafeBlockQueue<T>::cvNotEmpty_;
     using SafeBlockQueue<T>::cvNotFull_;
     using SafeBlockQueue<T>::queueT_;
+    using SafeBlockQueue<T>::closed_;
 
     std::atomic<int> unfinishedTaskCount_;
     std::condition_variable cvAllTasksDone_;
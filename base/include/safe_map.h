@@ -16,8 +16,11 @@
 #ifndef UTILS_BASE_SAFE_MAP_H
 #define UTILS_BASE_SAFE_MAP_H
 
+#include <functional>
 #include <map>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace OHOS {
 
@@ -42,11 +45,24 @@ public:
         return *this;
     }
 
+    /*
+     * the lookup and the insertion of a missing key are protected, but the value is used through
+     * the reference after the lock is released, use Access to read or change it under the lock.
+     */
     V& operator[](const K& key)
     {
+        std::lock_guard<std::mutex> lock(mutex_);
         return map_[key];
     }
 
+    // call accessor(value) with the lock held, a default value is inserted first if key is absent
+    template <typename Accessor>
+    void Access(const K& key, Accessor&& accessor)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        accessor(map_[key]);
+    }
+
     // when multithread calling size() return a tmp status, some threads may insert just after size() call
     int Size()
     {
@@ -137,6 +153,44 @@ public:
         }
     }
 
+    static constexpr size_t DEFAULT_ITERATE_BATCH = 64;
+
+    using SafeMapSnapshotCallBack = std::function<void(const K&, const V&)>;
+
+    /*
+     * Iterate over copies of the entries, taken under the lock batchSize at a time, the callback
+     * runs without the lock so writers are only held up while a batch is copied. Entries are
+     * visited in key order, each one at most once, changes made between batches may or may not be seen.
+     */
+    void IterateInBatches(const SafeMapSnapshotCallBack& callback, size_t batchSize = DEFAULT_ITERATE_BATCH)
+    {
+        if (batchSize == 0) {
+            batchSize = DEFAULT_ITERATE_BATCH;
+        }
+
+        std::vector<std::pair<K, V>> batch;
+        batch.reserve(batchSize);
+        bool started = false;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = started ? map_.upper_bound(batch.back().first) : map_.begin();
+                batch.clear();
+                for (; (it != map_.end()) && (batch.size() < batchSize); it++) {
+                    batch.emplace_back(it->first, it->second);
+                }
+            }
+            if (batch.empty()) {
+                return;
+            }
+
+            started = true;
+            for (auto& entry : batch) {
+                callback(entry.first, entry.second);
+            }
+        }
+    }
+
 private:
     std::mutex mutex_;
     std::map<K, V> map_;
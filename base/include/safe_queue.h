@@ -16,28 +16,30 @@
 #ifndef UTILS_BASE_SAFE_QUEUE_H
 #define UTILS_BASE_SAFE_QUEUE_H
 
+#include <algorithm>
 #include <deque>
+#include <iterator>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace OHOS {
 
-template <typename T>
+/*
+ * Derived provides the end elements are popped from, called with mutex_ held:
+ *     static void DoPop(std::deque<T>& deque, T& pt);  deque is not empty
+ *     static void DoPopAll(std::deque<T>& deque, std::vector<T>& pts);  append in pop order
+ */
+template <typename T, typename Derived>
 class SafeQueueInner {
 
 public:
     SafeQueueInner() {}
 
-    virtual ~SafeQueueInner()
-    {
-        if (!deque_.empty()) {
-            deque_.clear();
-        }
-    }
-
     void Erase(T& Object)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        deque_.remove(Object);
+        deque_.erase(std::remove(deque_.begin(), deque_.end(), Object), deque_.end());
     }
 
     bool Empty()
@@ -49,7 +51,34 @@ public:
     void Push(const T& pt)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        return DoPush(pt);
+        deque_.push_back(pt);
+    }
+
+    void Push(T&& pt)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deque_.push_back(std::move(pt));
+    }
+
+    template <typename... Args>
+    void Emplace(Args&&... args)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deque_.emplace_back(std::forward<Args>(args)...);
+    }
+
+    // push all under one lock, in the order of pts
+    void PushBatch(const std::vector<T>& pts)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deque_.insert(deque_.end(), pts.begin(), pts.end());
+    }
+
+    void PushBatch(std::vector<T>&& pts)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deque_.insert(deque_.end(), std::make_move_iterator(pts.begin()), std::make_move_iterator(pts.end()));
+        pts.clear();
     }
 
     void Clear()
@@ -71,62 +100,84 @@ public:
     bool Pop(T& pt)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        return DoPop(pt);
+        if (deque_.empty()) {
+            return false;
+        }
+
+        Derived::DoPop(deque_, pt);
+        return true;
+    }
+
+    /*
+     * take all elements at once and append them to pts in pop order,
+     * the lock is only held to swap the container out.
+     * return the number of elements appended.
+     */
+    size_t PopAll(std::vector<T>& pts)
+    {
+        std::deque<T> taken;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            taken.swap(deque_);
+        }
+
+        pts.reserve(pts.size() + taken.size());
+        Derived::DoPopAll(taken, pts);
+        return taken.size();
     }
 
 protected:
-    virtual void DoPush(const T& pt) = 0;
-    virtual bool DoPop(T& pt) = 0;
+    // not virtual, so only SafeQueue and SafeStack may destroy it
+    ~SafeQueueInner()
+    {
+        if (!deque_.empty()) {
+            deque_.clear();
+        }
+    }
 
     std::deque<T> deque_;
     std::mutex mutex_;
 };
 
 template <typename T>
-class SafeQueue : public SafeQueueInner<T> {
+class SafeQueue : public SafeQueueInner<T, SafeQueue<T>> {
 
 protected:
-    using SafeQueueInner<T>::deque_;
-    using SafeQueueInner<T>::mutex_;
+    using SafeQueueInner<T, SafeQueue<T>>::deque_;
+    using SafeQueueInner<T, SafeQueue<T>>::mutex_;
 
-    virtual void DoPush(const T& pt) override
+    friend class SafeQueueInner<T, SafeQueue<T>>;
+
+    static void DoPop(std::deque<T>& deque, T& pt)
     {
-        deque_.push_back(pt);
+        pt = std::move(deque.front());
+        deque.pop_front();
     }
 
-    virtual bool DoPop(T& pt) override
+    static void DoPopAll(std::deque<T>& deque, std::vector<T>& pts)
     {
-        if (deque_.size() > 0) {
-            pt = deque_.front();
-            deque_.pop_front();
-            return true;
-        }
-
-        return false;
+        std::move(deque.begin(), deque.end(), std::back_inserter(pts));
     }
 };
 
 template <typename T>
-class SafeStack : public SafeQueueInner<T> {
+class SafeStack : public SafeQueueInner<T, SafeStack<T>> {
 
 protected:
-    using SafeQueueInner<T>::deque_;
-    using SafeQueueInner<T>::mutex_;
+    using SafeQueueInner<T, SafeStack<T>>::deque_;
+    using SafeQueueInner<T, SafeStack<T>>::mutex_;
+
+    friend class SafeQueueInner<T, SafeStack<T>>;
 
-    virtual void DoPush(const T& pt) override
+    static void DoPop(std::deque<T>& deque, T& pt)
     {
-        deque_.push_back(pt);
+        pt = std::move(deque.back());
+        deque.pop_back();
     }
 
-    virtual bool DoPop(T& pt) override
+    static void DoPopAll(std::deque<T>& deque, std::vector<T>& pts)
     {
-        if (deque_.size() > 0) {
-            pt = deque_.back();
-            deque_.pop_back();
-            return true;
-        }
-
-        return false;
+        std::move(deque.rbegin(), deque.rend(), std::back_inserter(pts));
     }
 };
 
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_SNAPSHOT_MAP_H
+#define UTILS_BASE_SNAPSHOT_MAP_H
+
+#include "nocopyable.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace OHOS {
+
+/*
+ * Copy-on-write map with the interface of SafeMap, for tables read far more often than written.
+ *
+ * The content is an immutable std::map published through a shared_ptr. Readers take the current
+ * version, never copy it and never wait for a writer to finish a change; a version stays valid
+ * for as long as a reader holds it and is freed by the last one. Writers are serialized, each
+ * change copies the map and publishes the copy, so several changes should be grouped with Modify.
+ *
+ * The shared_ptr is guarded by a mutex of this map, held only to copy or swap the pointer, so the
+ * layout is the same whatever the C++ standard the including code is built with.
+ */
+template <typename K, typename V>
+class SnapshotMap : public NoCopyable {
+public:
+    using Map = std::map<K, V>;
+    using Snapshot = std::shared_ptr<const Map>;
+
+    SnapshotMap() : current_(std::make_shared<const Map>()) {}
+
+    ~SnapshotMap() {}
+
+    // an immutable version of the whole map, later writes are not seen through it
+    Snapshot GetSnapshot() const
+    {
+        std::lock_guard<std::mutex> lock(currentMutex_);
+        return current_;
+    }
+
+    int Size() const
+    {
+        return static_cast<int>(GetSnapshot()->size());
+    }
+
+    bool IsEmpty() const
+    {
+        return GetSnapshot()->empty();
+    }
+
+    bool Find(const K& key, V& value) const
+    {
+        Snapshot snapshot = GetSnapshot();
+        auto iter = snapshot->find(key);
+        if (iter == snapshot->end()) {
+            return false;
+        }
+        value = iter->second;
+        return true;
+    }
+
+    bool Insert(const K& key, const V& value)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        Snapshot current = GetSnapshot();
+        if (current->count(key) != 0) {
+            return false;
+        }
+        std::shared_ptr<Map> next = std::make_shared<Map>(*current);
+        next->emplace(key, value);
+        Publish(std::move(next));
+        return true;
+    }
+
+    void EnsureInsert(const K& key, const V& value)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        std::shared_ptr<Map> next = std::make_shared<Map>(*GetSnapshot());
+        next->insert_or_assign(key, value);
+        Publish(std::move(next));
+    }
+
+    bool FindOldAndSetNew(const K& key, V& oldValue, const V& newValue)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        Snapshot current = GetSnapshot();
+        auto iter = current->find(key);
+        if (iter == current->end()) {
+            return false;
+        }
+        oldValue = iter->second;
+        std::shared_ptr<Map> next = std::make_shared<Map>(*current);
+        (*next)[key] = newValue;
+        Publish(std::move(next));
+        return true;
+    }
+
+    void Erase(const K& key)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        Snapshot current = GetSnapshot();
+        if (current->count(key) == 0) {
+            return;
+        }
+        std::shared_ptr<Map> next = std::make_shared<Map>(*current);
+        next->erase(key);
+        Publish(std::move(next));
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        Publish(std::make_shared<Map>());
+    }
+
+    // apply any number of changes to one copy of the map and publish them at once
+    void Modify(const std::function<void(Map&)>& modifier)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        std::shared_ptr<Map> next = std::make_shared<Map>(*GetSnapshot());
+        modifier(*next);
+        Publish(std::move(next));
+    }
+
+    using SnapshotMapCallBack = std::function<void(const K&, const V&)>;
+
+    // visit one version in key order without blocking writers
+    void Iterate(const SnapshotMapCallBack& callback) const
+    {
+        Snapshot snapshot = GetSnapshot();
+        for (auto& entry : *snapshot) {
+            callback(entry.first, entry.second);
+        }
+    }
+
+private:
+    // called with writeMutex_ held
+    void Publish(std::shared_ptr<Map>&& next)
+    {
+        Snapshot previous(std::move(next));
+        {
+            std::lock_guard<std::mutex> lock(currentMutex_);
+            current_.swap(previous);
+        }
+        // the old version is freed, when this was its last holder, outside currentMutex_
+    }
+
+    Snapshot current_;
+    mutable std::mutex currentMutex_;  // guards current_ only
+    std::mutex writeMutex_;
+};
+
+} // namespace OHOS
+
+#endif
@@ -19,7 +19,10 @@
 #include <algorithm>
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <sys/types.h>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace OHOS {
@@ -43,6 +46,9 @@ public:
 
     SortedVector(const std::vector<TYPE>& orivect);
 
+    // build from a vector sorted in place and taken over, no element is copied
+    static SortedVector<TYPE, AllowDuplicate> FromUnsorted(std::vector<TYPE>&& invec);
+
     virtual ~SortedVector() {}
     // copy operator
     SortedVector<TYPE, AllowDuplicate>& operator=(const SortedVector<TYPE, false>& rhs);
@@ -71,6 +77,16 @@ public:
     ssize_t IndexOf(const TYPE& item) const;
     size_t OrderOf(const TYPE& item) const;
 
+    /*
+     * lookup by a KEY comparable with TYPE, without building a TYPE:
+     * needs TYPE < KEY, KEY < TYPE and TYPE == KEY.
+     * keys implicitly convertible to TYPE still go through the overloads above.
+     */
+    template <typename KEY, typename = std::enable_if_t<!std::is_convertible<const KEY&, TYPE>::value>>
+    ssize_t IndexOf(const KEY& key) const;
+    template <typename KEY, typename = std::enable_if_t<!std::is_convertible<const KEY&, TYPE>::value>>
+    size_t OrderOf(const KEY& key) const;
+
     // accessors
     inline const TYPE& operator[](size_t index) const { return vec_[index]; }
 
@@ -95,8 +111,13 @@ public:
 
     // merge a vector into this one
     size_t Merge(const std::vector<TYPE>& invec);
+    size_t Merge(std::vector<TYPE>&& invec);
     size_t Merge(const SortedVector<TYPE, AllowDuplicate>& sortedVector);
 
+    // add the items of [first, last) with one sort and one merge instead of one insert each
+    template <typename InputIt>
+    size_t AddRange(InputIt first, InputIt last);
+
     // erase an item at index
     iterator Erase(size_t index)
     {
@@ -131,6 +152,19 @@ public:
     static const ssize_t CAPCITY_NOT_CHANGED = -1;
 
 private:
+    // below this number of elements the searched range is left to the cache as is
+    static const size_t PREFETCH_THRESHOLD = 64;
+
+    // append the sorted range [first, last) and merge it with the items already there
+    template <typename ForwardIt>
+    void MergeSorted(ForwardIt first, ForwardIt last);
+    void SortAndTake(std::vector<TYPE>& invec);
+
+    template <typename KEY>
+    size_t LowerBound(const KEY& key) const;
+    template <typename KEY>
+    size_t UpperBound(const KEY& key) const;
+
     std::vector<TYPE> vec_;
 };
 
@@ -183,37 +217,99 @@ SortedVector<TYPE, AllowDuplicate>& SortedVector<TYPE, AllowDuplicate>::operator
     return *this;
 }
 
+/*
+ * Branchless binary search: the range is halved every round whatever the comparison gives, and the
+ * half is picked with a conditional move instead of a branch, so lookups of arithmetic keys do not
+ * mispredict. Both possible next probes are prefetched while the range is large.
+ */
+template <class TYPE, bool AllowDuplicate>
+template <typename KEY>
+size_t SortedVector<TYPE, AllowDuplicate>::LowerBound(const KEY& key) const
+{
+    size_t n = vec_.size();
+    if (n == 0) {
+        return 0;
+    }
+
+    const TYPE* base = vec_.data();
+    while (n > 1) {
+        size_t half = n / 2; // 2: halve the range
+        if (n > PREFETCH_THRESHOLD) {
+            __builtin_prefetch(base + half / 2); // 2: middle of the lower half
+            __builtin_prefetch(base + half + half / 2); // 2: middle of the upper half
+        }
+        base = (base[half] < key) ? (base + half) : base;
+        n -= half;
+    }
+    return (base - vec_.data()) + static_cast<size_t>(*base < key);
+}
+
+template <class TYPE, bool AllowDuplicate>
+template <typename KEY>
+size_t SortedVector<TYPE, AllowDuplicate>::UpperBound(const KEY& key) const
+{
+    size_t n = vec_.size();
+    if (n == 0) {
+        return 0;
+    }
+
+    const TYPE* base = vec_.data();
+    while (n > 1) {
+        size_t half = n / 2; // 2: halve the range
+        if (n > PREFETCH_THRESHOLD) {
+            __builtin_prefetch(base + half / 2); // 2: middle of the lower half
+            __builtin_prefetch(base + half + half / 2); // 2: middle of the upper half
+        }
+        base = (key < base[half]) ? base : (base + half);
+        n -= half;
+    }
+    return (base - vec_.data()) + static_cast<size_t>(!(key < *base));
+}
+
 template <class TYPE, bool AllowDuplicate>
 ssize_t SortedVector<TYPE, AllowDuplicate>::IndexOf(const TYPE& item) const
 {
-    if (vec_.empty()) {
+    size_t index = LowerBound(item);
+    if (index == vec_.size() || !(vec_[index] == item)) {
         return NOT_FOUND;
     }
+    return index;
+}
 
-    auto it = std::lower_bound(std::begin(vec_), std::end(vec_), item);
-    if (it == vec_.end() || !(*it == item)) {
+template <class TYPE, bool AllowDuplicate>
+size_t SortedVector<TYPE, AllowDuplicate>::OrderOf(const TYPE& item) const
+{
+    return UpperBound(item);
+}
+
+template <class TYPE, bool AllowDuplicate>
+template <typename KEY, typename>
+ssize_t SortedVector<TYPE, AllowDuplicate>::IndexOf(const KEY& key) const
+{
+    size_t index = LowerBound(key);
+    if (index == vec_.size() || !(vec_[index] == key)) {
         return NOT_FOUND;
     }
-    return it - vec_.begin();
+    return index;
 }
 
 template <class TYPE, bool AllowDuplicate>
-size_t SortedVector<TYPE, AllowDuplicate>::OrderOf(const TYPE& item) const
+template <typename KEY, typename>
+size_t SortedVector<TYPE, AllowDuplicate>::OrderOf(const KEY& key) const
 {
-    auto it = std::upper_bound(vec_.begin(), vec_.end(), item);
-    return it - vec_.begin();
+    return UpperBound(key);
 }
 
 template <class TYPE, bool AllowDuplicate>
 ssize_t SortedVector<TYPE, AllowDuplicate>::Add(const TYPE& item)
 {
-    ssize_t index = IndexOf(item);
-    if (index != NOT_FOUND && !AllowDuplicate) {
+    // one search: with duplicates refused, an equal item can only be just before the insert position
+    size_t index = UpperBound(item);
+    if (!AllowDuplicate && index > 0 && vec_[index - 1] == item) {
         return ADD_FAIL;
     }
 
-    auto it = std::upper_bound(vec_.begin(), vec_.end(), item);
-    it = vec_.insert(it, item);
+    auto it = vec_.insert(vec_.begin() + index, item);
     return it - vec_.begin();
 }
 
@@ -225,35 +321,83 @@ SortedVector<TYPE, AllowDuplicate>::SortedVector(const std::vector<TYPE>& invec)
     }
 
     std::vector<TYPE> newvector(invec);
-    std::sort(newvector.begin(), newvector.end());
-    if (AllowDuplicate) {
-        vec_.swap(newvector);
-    } else {
-        std::unique_copy(newvector.begin(), newvector.end(), std::back_inserter(vec_));
+    SortAndTake(newvector);
+}
+
+template <class TYPE, bool AllowDuplicate>
+SortedVector<TYPE, AllowDuplicate> SortedVector<TYPE, AllowDuplicate>::FromUnsorted(std::vector<TYPE>&& invec)
+{
+    SortedVector<TYPE, AllowDuplicate> sortedVector;
+    sortedVector.SortAndTake(invec);
+    return sortedVector;
+}
+
+template <class TYPE, bool AllowDuplicate>
+void SortedVector<TYPE, AllowDuplicate>::SortAndTake(std::vector<TYPE>& invec)
+{
+    std::sort(invec.begin(), invec.end());
+    if (!AllowDuplicate) {
+        invec.erase(std::unique(invec.begin(), invec.end()), invec.end());
     }
+    vec_.swap(invec);
 }
 
 template <class TYPE, bool AllowDuplicate>
 size_t SortedVector<TYPE, AllowDuplicate>::Merge(const std::vector<TYPE>& invec)
 {
-    SortedVector<TYPE, AllowDuplicate> sortedVector(invec);
-    Merge(sortedVector);
+    std::vector<TYPE> newvector(invec);
+    return Merge(std::move(newvector));
+}
+
+template <class TYPE, bool AllowDuplicate>
+size_t SortedVector<TYPE, AllowDuplicate>::Merge(std::vector<TYPE>&& invec)
+{
+    std::sort(invec.begin(), invec.end());
+    MergeSorted(std::make_move_iterator(invec.begin()), std::make_move_iterator(invec.end()));
+    // left with moved-from items only
+    invec.clear();
     return vec_.size();
 }
 
 template <class TYPE, bool AllowDuplicate>
 size_t SortedVector<TYPE, AllowDuplicate>::Merge(const SortedVector<TYPE, AllowDuplicate>& sortedVector)
 {
-    std::vector<TYPE> newVec;
-    std::merge(vec_.begin(), vec_.end(), sortedVector.Begin(), sortedVector.End(), std::back_inserter(newVec));
-    if (!AllowDuplicate) {
-        vec_.clear();
-        std::unique_copy(newVec.begin(), newVec.end(), std::back_inserter(vec_));
+    if (&sortedVector == this) {
+        std::vector<TYPE> self(vec_);
+        MergeSorted(std::make_move_iterator(self.begin()), std::make_move_iterator(self.end()));
     } else {
-        vec_.swap(newVec);
+        MergeSorted(sortedVector.Begin(), sortedVector.End());
     }
     return vec_.size();
 }
 
+template <class TYPE, bool AllowDuplicate>
+template <typename InputIt>
+size_t SortedVector<TYPE, AllowDuplicate>::AddRange(InputIt first, InputIt last)
+{
+    return Merge(std::vector<TYPE>(first, last));
+}
+
+/*
+ * The new items are appended and merged in place with the old ones, inplace_merge uses a temporary
+ * buffer when it can get one. The capacity grows geometrically with insert, so a run of small
+ * merges reallocates only a logarithmic number of times.
+ */
+template <class TYPE, bool AllowDuplicate>
+template <typename ForwardIt>
+void SortedVector<TYPE, AllowDuplicate>::MergeSorted(ForwardIt first, ForwardIt last)
+{
+    if (first == last) {
+        return;
+    }
+
+    size_t oldSize = vec_.size();
+    vec_.insert(vec_.end(), first, last);
+    std::inplace_merge(vec_.begin(), vec_.begin() + oldSize, vec_.end());
+    if (!AllowDuplicate) {
+        vec_.erase(std::unique(vec_.begin(), vec_.end()), vec_.end());
+    }
+}
+
 } // namespace OHOS
 #endif
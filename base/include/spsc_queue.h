@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_SPSC_QUEUE_H
+#define UTILS_BASE_SPSC_QUEUE_H
+
+#include "cache_line.h"
+#include "nocopyable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace OHOS {
+
+/*
+ * Bounded wait-free queue for exactly one producer thread and one consumer thread.
+ *
+ * Push* may only be called by the producer and Pop* by the consumer. Each side
+ * owns its index and keeps a cached copy of the other side's index, which it only
+ * reloads when the cached value does not leave enough room (producer) or elements
+ * (consumer), so the indexes rarely move between cores. Batch calls move up to N
+ * elements with a single index update. capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SpscQueue : public NoCopyable {
+public:
+    explicit SpscQueue(int capacity)
+        : mask_(RoundUpCapacity(capacity) - 1), cells_(new Cell[mask_ + 1])
+    {
+    }
+
+    ~SpscQueue()
+    {
+        size_t head = consumer_.head.load(std::memory_order_relaxed);
+        size_t tail = producer_.tail.load(std::memory_order_relaxed);
+        for (; head != tail; ++head) {
+            ElemAt(head)->~T();
+        }
+    }
+
+    bool PushNoWait(T const& elem)
+    {
+        return PushBatch(&elem, 1) == 1;
+    }
+
+    bool PushNoWait(T&& elem)
+    {
+        size_t tail = producer_.tail.load(std::memory_order_relaxed);
+        if (FreeSlots(tail, 1) == 0) {
+            return false;
+        }
+        new (ElemAt(tail)) T(std::move(elem));
+        producer_.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // push elems[0, count) as far as room allows, return the number pushed
+    size_t PushBatch(const T* elems, size_t count)
+    {
+        size_t tail = producer_.tail.load(std::memory_order_relaxed);
+        size_t pushed = std::min(count, FreeSlots(tail, count));
+        for (size_t i = 0; i < pushed; ++i) {
+            new (ElemAt(tail + i)) T(elems[i]);
+        }
+        if (pushed > 0) {
+            producer_.tail.store(tail + pushed, std::memory_order_release);
+        }
+        return pushed;
+    }
+
+    bool PopNotWait(T& outtask)
+    {
+        return PopBatch(&outtask, 1) == 1;
+    }
+
+    // pop at most count elements into out[0, count), return the number popped
+    size_t PopBatch(T* out, size_t count)
+    {
+        size_t head = consumer_.head.load(std::memory_order_relaxed);
+        size_t popped = std::min(count, UsedSlots(head, count));
+        for (size_t i = 0; i < popped; ++i) {
+            T* elem = ElemAt(head + i);
+            out[i] = std::move(*elem);
+            elem->~T();
+        }
+        if (popped > 0) {
+            consumer_.head.store(head + popped, std::memory_order_release);
+        }
+        return popped;
+    }
+
+    // a tmp status when called with the other side running
+    unsigned int Size() const
+    {
+        size_t head = consumer_.head.load(std::memory_order_acquire);
+        size_t tail = producer_.tail.load(std::memory_order_acquire);
+        return (tail > head) ? static_cast<unsigned int>(tail - head) : 0;
+    }
+
+    bool IsEmpty() const
+    {
+        return Size() == 0;
+    }
+
+    bool IsFull() const
+    {
+        return Size() >= Capacity();
+    }
+
+    size_t Capacity() const
+    {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) ProducerSide {
+        std::atomic<size_t> tail {0};
+        size_t cachedHead {0};
+    };
+
+    struct alignas(CACHE_LINE_SIZE) ConsumerSide {
+        std::atomic<size_t> head {0};
+        size_t cachedTail {0};
+    };
+
+    static size_t RoundUpCapacity(int capacity)
+    {
+        size_t size = 1;
+        while (static_cast<int64_t>(size) < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    T* ElemAt(size_t pos)
+    {
+        return reinterpret_cast<T*>(&cells_[pos & mask_].storage);
+    }
+
+    // producer only, the head of the consumer is reloaded only if the cached one leaves less than wanted
+    size_t FreeSlots(size_t tail, size_t wanted)
+    {
+        size_t capacity = Capacity();
+        if (capacity - (tail - producer_.cachedHead) < wanted) {
+            producer_.cachedHead = consumer_.head.load(std::memory_order_acquire);
+        }
+        return capacity - (tail - producer_.cachedHead);
+    }
+
+    // consumer only, the tail of the producer is reloaded only if the cached one offers less than wanted
+    size_t UsedSlots(size_t head, size_t wanted)
+    {
+        if (consumer_.cachedTail - head < wanted) {
+            consumer_.cachedTail = producer_.tail.load(std::memory_order_acquire);
+        }
+        return consumer_.cachedTail - head;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    ProducerSide producer_;
+    ConsumerSide consumer_;
+};
+
+} // namespace OHOS
+
+#endif
@@ -16,7 +16,11 @@
 #define THREAD_POOL_H
 
 #include "nocopyable.h"
+#include "latency_histogram.h"
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include <functional>
@@ -31,35 +35,176 @@ class ThreadPool : public NoCopyable {
 public:
     typedef std::function<void()> Task;
 
+    // what to do with a new task when the queue reaches maxTaskNum
+    enum class OverloadPolicy {
+        BLOCK,        // wait until a worker takes a task(default)
+        CALLER_RUNS,  // run the task in the calling thread
+        DROP_OLDEST,  // discard the oldest task in the queue to make room
+        REJECT,       // do not add the task
+    };
+
     explicit ThreadPool(const std::string &name = std::string());
     ~ThreadPool();
 
     uint32_t Start(int threadsNum);
     void Stop();
+    /*
+     * With OverloadPolicy::REJECT, or DROP_OLDEST when no queued task can be discarded, a task that does not
+     * fit is logged and counted by GetRejectedTaskNum only; callers that need to know use TryAddTask.
+     */
     void AddTask(const Task& f);
     void SetMaxTaskNum(int maxSize) { maxTaskNum_ = maxSize; }
 
+    /*
+     * timeoutMs: range [-1, INT32MAX]
+     *            -1: wait for ever while the queue is full, as AddTask(f) with OverloadPolicy::BLOCK;
+     *            0: no wait;
+     *            others: wait at most timeoutMs
+     * when the queue is still full the overload policy is applied, with OverloadPolicy::BLOCK the task is rejected.
+     * return ERR_OK if the task is queued or run by the caller, ERR_TIMED_OUT or ERR_WOULD_BLOCK if rejected.
+     */
+    uint32_t AddTask(const Task& f, int timeoutMs);
+    // never waits, same as AddTask(f, 0)
+    uint32_t TryAddTask(const Task& f) { return AddTask(f, 0); }
+
+    /*
+     * Queue tasks of the library itself, helpers of parallel algorithms and coroutine resumptions.
+     * Whatever the overload policy it never waits, never discards a queued task and is never counted
+     * as a rejection.
+     * mustRun false: not queued if the queue is full or the pool is not running, return false;
+     *         true:  queued even beyond maxTaskNum and never discarded by DROP_OLDEST later,
+     *                run in the calling thread if the pool is not running, always return true.
+     */
+    bool AddInternalTask(const Task& f, bool mustRun);
+
+    /*
+     * AddTask(f) only waits with OverloadPolicy::BLOCK, other policies are applied immediately.
+     */
+    void SetOverloadPolicy(OverloadPolicy policy) { overloadPolicy_ = policy; }
+    OverloadPolicy GetOverloadPolicy() const { return overloadPolicy_; }
+
+    /*
+     * Awaitable of C++20 coroutines, co_await pool.Schedule() resumes the coroutine in a worker thread.
+     * The resumption is queued by AddInternalTask(mustRun true): it never waits for room in a full queue
+     * and is never discarded. If the pool has no thread the coroutine goes on in the calling thread.
+     */
+    class ScheduleAwaiter {
+    public:
+        explicit ScheduleAwaiter(ThreadPool& pool) : pool_(pool) {}
+
+        bool await_ready() const noexcept { return pool_.GetThreadsNum() == 0; }
+
+        template <typename Handle>
+        void await_suspend(Handle handle)
+        {
+            pool_.AddInternalTask([handle]() mutable { handle.resume(); }, true);
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        ThreadPool& pool_;
+    };
+
+    ScheduleAwaiter Schedule() { return ScheduleAwaiter(*this); }
+
+    /*
+     * Bind worker threads to the given cpus, must be called before Start.
+     * perWorker false: every worker may run on any cpu of the set;
+     *           true:  worker i is bound to cpus[i % cpus.size()] only.
+     */
+    uint32_t SetCpuAffinity(const std::vector<int>& cpus, bool perWorker = false);
+
+    /*
+     * Shard the task queue per NUMA node, must be called before Start.
+     * Workers are spread over the nodes and bound to the cpus of their node,
+     * AddTask prefers the queue of the node the caller is running on, and an
+     * idle worker steals from the other nodes, again every 10ms while its own queue stays empty.
+     * maxTaskNum applies to each node queue respectively.
+     */
+    uint32_t SetNumaAware(bool numaAware);
+
     // for testability
     size_t GetMaxTaskNum() const { return maxTaskNum_; }
     size_t GetCurTaskNum();
     size_t GetThreadsNum() const { return threads_.size(); }
+    size_t GetQueuesNum() const { return queues_.size(); }
     std::string GetName() const { return myName_; }
 
+    /*
+     * Metrics below are lock-free, they never contend with AddTask or the workers.
+     * Histograms are in microseconds.
+     */
+    uint64_t GetAddedTaskNum() const { return addedTaskNum_.load(std::memory_order_relaxed); }
+    uint64_t GetFinishedTaskNum() const { return finishedTaskNum_.load(std::memory_order_relaxed); }
+    // times AddTask waited because the queue reached maxTaskNum
+    uint64_t GetBlockedAddNum() const { return blockedAddNum_.load(std::memory_order_relaxed); }
+    // tasks discarded by OverloadPolicy::DROP_OLDEST
+    uint64_t GetDroppedTaskNum() const { return droppedTaskNum_.load(std::memory_order_relaxed); }
+    // tasks rejected because of a full queue
+    uint64_t GetRejectedTaskNum() const { return rejectedTaskNum_.load(std::memory_order_relaxed); }
+    // tasks added but not taken by a worker yet
+    size_t GetPendingTaskNum() const;
+    const LatencyHistogram& GetQueueWaitHistogram() const { return queueWaitUs_; }
+    const LatencyHistogram& GetRunTimeHistogram() const { return runTimeUs_; }
+    // share of the time since Start that worker index spent running tasks, range [0, 1]
+    double GetWorkerBusyRatio(size_t index) const;
+    void ResetMetrics();
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    struct TaskEntry {
+        Task task;
+        Clock::time_point addTime;
+        bool mustRun;  // from AddInternalTask, DROP_OLDEST skips it
+    };
+
+    struct TaskQueue {
+        std::mutex mutex;
+        std::condition_variable hasTaskToDo;
+        std::condition_variable acceptNewTask;
+        std::deque<TaskEntry> tasks;
+    };
+
+    struct Worker {
+        size_t queueIndex;  // index in queues_ this worker serves
+        std::vector<int> cpus;  // empty means no affinity
+        std::atomic<uint64_t> busyNs;
+        std::atomic<int64_t> sinceNs;  // start of the busy ratio period, in Clock ns
+    };
+
     // tasks in the queue reach the maximum set by maxQueueSize, means thread pool is full load.
-    bool Overloaded() const;
-    void WorkInThread(); // main        function in each thread.
-    Task ScheduleTask(); // fetch a task from the queue and execute
+    bool Overloaded(const TaskQueue& queue) const;
+    void PlaceWorkers(int numThreads);
+    size_t SelectQueue() const;  // queue of the caller's NUMA node
+    void SetupWorker(size_t index);  // name and bind the calling worker thread
+    void WorkInThread(size_t index); // main        function in each thread.
+    Task ScheduleTask(size_t queueIndex); // fetch a task from the queue and execute
+    Task StealTask(size_t queueIndex);  // fetch a task from the queues of other nodes
+    Task PopTask(TaskQueue& queue);  // called with queue.mutex held
 
 private:
     std::string myName_;
-    std::mutex mutex_;
-    std::condition_variable hasTaskToDo_;
-    std::condition_variable acceptNewTask_;
     std::vector<std::thread> threads_;
-    std::deque<Task> tasks_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<size_t> cpuToQueue_;  // cpu id to index in queues_, only used when numaAware_
+    std::vector<int> cpus_;
+    bool perWorkerAffinity_;
+    bool numaAware_;
     size_t maxTaskNum_;
-    bool running_;
+    std::atomic<OverloadPolicy> overloadPolicy_;
+    std::atomic<bool> running_;
+
+    std::atomic<uint64_t> addedTaskNum_;
+    std::atomic<uint64_t> takenTaskNum_;
+    std::atomic<uint64_t> finishedTaskNum_;
+    std::atomic<uint64_t> blockedAddNum_;
+    std::atomic<uint64_t> droppedTaskNum_;
+    std::atomic<uint64_t> rejectedTaskNum_;
+    LatencyHistogram queueWaitUs_;
+    LatencyHistogram runTimeUs_;
 };
 
 } // namespace OHOS
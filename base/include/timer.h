@@ -17,17 +17,25 @@
 #define UTILS_TIMER_H
 
 #include <sys/types.h>
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <list>
 #include <map>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "../src/event_reactor.h"
+#include "../src/timing_wheel.h"
+#include "common_timer_errors.h"
+#include "latency_histogram.h"
 
 namespace OHOS {
+class ThreadPool;
+
 namespace Utils {
 
 class Timer {
@@ -35,63 +43,273 @@ public:
     using TimerCallback = std::function<void ()>;
     using TimerCallbackPtr = std::shared_ptr<TimerCallback>;
     using TimerListCallback = std::function<void (int timerFd)>;
+    using TimerExecutor = std::function<void (const TimerCallback& task)>;
+
+    struct TimerRequest {
+        TimerCallback callback;
+        uint32_t interval;  // ms
+        bool once;
+    };
 
 public:
+    enum class Mode {
+        TIMERFD_PER_INTERVAL,  // one timerfd per interval, and one per once timer
+        TIMING_WHEEL,          // one timerfd for all, timers wait in a hierarchical timing wheel of 1ms ticks
+    };
+
     /*
      * if performance-sensitive, change "timeout" larger before Setup
      * default-value(1000ms), performance-estimate: occupy fixed-100us in every default-value(1000ms)
-     * timeout: range [-1, INT32MAX], but [-1,0] is not recommended
-     *          -1: wait for ever(until event-trigger);
+     * timeout: range [-1, INT32MAX], but 0 is not recommended
+     *          -1: wait for ever(until event-trigger), Shutdown wakes the thread up;
      *          0: no wait, occupy too much cpu time;
      *          others: wait(until event-trigger)
+     * mode: TIMING_WHEEL suits many short-lived once timers, register and unregister are O(1)
+     *       and need no file descriptor nor epoll_ctl.
      */
-    explicit Timer(const std::string& name, int timeoutMs = 1000);
-    virtual ~Timer() {}
+    explicit Timer(const std::string& name, int timeoutMs = 1000, Mode mode = Mode::TIMERFD_PER_INTERVAL);
+    virtual ~Timer();
 
+    // start the timer thread, also after Shutdown; TIMER_ERR_INVALID_VALUE if it is running already
     virtual uint32_t Setup();
 
     /*
      * useJoin true:    use std::thread::join(default)
      *         false:   use std::thread::detach(not recommended)
-     * if timeoutMs = -1 and no valid event-trigger in epoll_wait:
-     *                  use std::thread::detach inside to avoid deadloop
+     * the timer thread is woken up to stop at once, even with timeoutMs = -1
      */
     virtual void Shutdown(bool useJoin = true);
 
     uint32_t Register(const TimerCallback& callback, uint32_t interval /* ms */, bool once = false);
     void Unregister(uint32_t timerId);
 
+    /*
+     * Register many timers under one lock: periodic timers of one interval share a single new timerfd,
+     * and in TIMING_WHEEL mode the wheel timerfd is rearmed once for the whole batch.
+     * timerIds gets the id of every request in order, TIMER_ERR_DEAL_FAILED for the ones that failed.
+     * return TIMER_ERR_OK, or TIMER_ERR_DEAL_FAILED if any request failed.
+     */
+    uint32_t RegisterBatch(const std::vector<TimerRequest>& requests, std::vector<uint32_t>& timerIds);
+
+    /*
+     * Register without taking the lock of the timer: the timer is queued lock-free and the timer thread
+     * links it, with the others queued meanwhile, between two rounds of expirations, so bursts of
+     * registrations from many threads never hold the timer thread up. The interval counts from then.
+     * The id is returned at once and may be passed to Unregister right away, the timer is then never linked
+     * and its callback never runs. Timers queued before Setup
+     * are linked when the thread starts, the ones queued after Shutdown never are.
+     */
+    uint32_t RegisterAsync(const TimerCallback& callback, uint32_t interval /* ms */, bool once = false);
+
+    /*
+     * Run callbacks through executor instead of inline in the timer thread, call before Setup.
+     * The timer thread then only reads the timerfds and hands expirations over, so a slow callback
+     * delays neither other timers nor the next period of its own timer.
+     * Callbacks of one timer never run concurrently: an expiration while the previous callback is
+     * still queued or running is merged into one more run after it, as a late timerfd read does.
+     * A timer unregistered, or the Timer shut down, before its queued callback starts is skipped.
+     * An executor may also drop a task: that expiration is lost and the timer fires again at the next one.
+     * executor nullptr: run inline in the timer thread(default).
+     */
+    void SetExecutor(const TimerExecutor& executor);
+    /*
+     * executor of pool->TryAddTask(task), the timer thread never waits for room in a full pool:
+     * BLOCK and REJECT reject the expiration, CALLER_RUNS runs it in the timer thread, DROP_OLDEST discards
+     * the oldest queued task. A rejected expiration is lost as above and counted by GetDroppedCount.
+     */
+    void SetExecutor(ThreadPool* pool);
+
+    /*
+     * High resolution timers, in either mode: deadlines are CLOCK_MONOTONIC ns and all of them share one timerfd.
+     * RegisterUs: fire after, or every, intervalUs us; a periodic one keeps its phase, periods missed fire once.
+     *             intervalUs 0 is only valid with once.
+     * RegisterAt: fire once at deadlineNs of NowNs(), a deadline already passed fires at once.
+     * Both return the timer id for Unregister, or TIMER_ERR_DEAL_FAILED.
+     */
+    uint32_t RegisterUs(const TimerCallback& callback, uint64_t intervalUs, bool once = false);
+    uint32_t RegisterAt(const TimerCallback& callback, uint64_t deadlineNs);
+    static uint64_t NowNs();
+
+    /*
+     * Let high resolution timers fire up to slackUs late, so that the ones due within one slack window
+     * share a single wakeup; also the timer slack of the timer thread(PR_SET_TIMERSLACK). Call before Setup.
+     * slackUs 0: fire exactly, and the default timer slack of the thread(default).
+     */
+    void SetSlack(uint64_t slackUs);
+
+    /*
+     * Precision metrics in us, lock-free, readable from any thread, one record per expiration of a timer.
+     * lateness: actual minus scheduled firing time, taken when the callback is run or handed to the executor;
+     *           ms timers are due on whole ms in TIMING_WHEEL mode.
+     * callback time: how long callbacks run.
+     * overruns: periods missed because a periodic timer fired later than its next period.
+     * dropped: expirations rejected by the pool of SetExecutor(ThreadPool*).
+     */
+    const LatencyHistogram& GetLatenessHistogram() const { return latenessUs_; }
+    const LatencyHistogram& GetCallbackTimeHistogram() const { return *callbackUs_; }
+    uint64_t GetOverrunCount() const { return overruns_.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    void ResetMetrics();
+
+    class DelayAwaiter {
+    public:
+        DelayAwaiter(Timer& timer, uint32_t interval, ThreadPool* pool)
+            : timer_(timer), interval_(interval), pool_(pool), result_(TIMER_ERR_OK) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Handle>
+        bool await_suspend(Handle handle)
+        {
+            return Suspend([handle]() mutable { handle.resume(); });
+        }
+
+        uint32_t await_resume() const noexcept { return result_; }
+
+    private:
+        // false if the timer can not be registered, the coroutine then goes on at once
+        bool Suspend(const TimerCallback& resume);
+
+        Timer& timer_;
+        uint32_t interval_;
+        ThreadPool* pool_;
+        uint32_t result_;
+    };
+
+    /*
+     * Awaitable of C++20 coroutines, co_await timer.Delay(interval) resumes the coroutine after interval ms
+     * without blocking any thread meanwhile.
+     * pool nullptr: resume in the timer thread, the coroutine must suspend again or finish quickly;
+     *      others:  resume in a worker of pool, queued by AddInternalTask(mustRun true) which neither blocks
+     *               the timer thread nor gets discarded.
+     * co_await returns TIMER_ERR_OK, or TIMER_ERR_DEAL_FAILED at once if the timer can not be registered.
+     * Delays still pending at Shutdown are resumed by it with TIMER_ERR_DEAL_FAILED.
+     */
+    DelayAwaiter Delay(uint32_t interval /* ms */, ThreadPool* pool = nullptr)
+    {
+        return DelayAwaiter(*this, interval, pool);
+    }
+
 private:
     void MainLoop();
     void OnTimer(int timerFd);
+    void OnTimerExpiry(uint64_t scheduledNs, uint64_t overruns);
     virtual uint32_t DoRegister(const TimerListCallback& callback, uint32_t interval, bool once, int &timerFd);
-    virtual void DoUnregister(uint32_t interval);
+    virtual void DoUnregister(int timerFd);
     void DoTimerListCallback(const TimerListCallback& callback, int timerFd);
     uint32_t GetValidId(uint32_t timerId) const;
+    uint32_t NextTimerId();
+    uint32_t UniqueTimerId();
     int GetTimerFd(uint32_t interval /* ms */);
-    void EraseUnusedTimerId(uint32_t interval, const std::vector<uint32_t>& unusedIds);
+    uint32_t SetupWheel();
+    void ArmWheel();
+    void OnWheelTimer();
+    uint32_t RegisterHighRes(const TimerCallback& callback, uint64_t deadlineNs, uint64_t periodNs, bool once);
+    uint32_t SetupHighRes();
+    void ArmHighRes();
+    void OnHighResTimer();
+    void ResumePendingDelays();
 
 private:
-    struct TimerEntry {
+    struct TimerEntry : public WheelNode {
         uint32_t       timerId;  // unique id
         uint32_t       interval;  // million second
         TimerCallback  callback;
         bool           once;
         int            timerFd;
+        uint64_t       seq;  // order of registration
+        std::list<std::shared_ptr<TimerEntry>>::iterator handle;  // position in fdToTimers_[timerFd]
+        bool           highRes = false;
+        uint64_t       firedNs = 0;  // due time of the expiration being dispatched, wheel and high resolution
+        uint64_t       firedOverruns = 0;
+        uint64_t       periodNs = 0;  // high resolution periodic timers only
+        std::multimap<uint64_t, TimerEntry*>::iterator hrHandle;  // position in hrQueue_, end() once fired
+        std::atomic<int> dispatchState {0};  // IDLE, RUNNING or RERUN, only used with an executor
+        std::atomic<bool> cancelled {false};
     };
 
     using TimerEntryPtr = std::shared_ptr<TimerEntry>;
     using TimerEntryList = std::list<TimerEntryPtr>;
 
-    std::map<uint32_t, TimerEntryList> intervalToTimers_;  // interval to TimerEntryList
-    std::map<uint32_t, TimerEntryPtr> timerToEntries_;  // timer_id to TimerEntry
+    // held by the task handed to executor_, a task destroyed unrun sets the timer back to IDLE
+    struct DispatchGuard {
+        TimerEntryPtr entry;
+        bool ran = false;
+        ~DispatchGuard();
+    };
+
+    // a suspended Delay, resumed once by its timer or by Shutdown
+    struct DelayState {
+        TimerCallback resume;
+        uint32_t* result;  // of the awaiter, valid until resume is called
+        std::atomic<bool> done {false};
+    };
+
+    // a queued RegisterAsync, pushed on submitted_
+    struct Submission {
+        TimerEntryPtr entry;
+        Submission* next;
+    };
+
+    static TimerEntryPtr CreateEntry(const TimerCallback& callback, uint32_t interval, bool once, uint32_t timerId);
+    uint32_t LinkEntry(const TimerEntryPtr& entry, uint64_t startTick);
+    bool UnregisterLocked(uint32_t timerId);
+    void EraseEntry(const TimerEntryPtr& entry);
+    void EraseFiredOnce(const std::vector<TimerEntryPtr>& fired);
+    void DrainSubmitted();
+    void Dispatch(const TimerEntryPtr& entry, uint64_t scheduledNs, uint64_t overruns);
+    static void RunSerialized(const TimerEntryPtr& entry, const std::shared_ptr<std::atomic<bool>>& stopped,
+        const std::shared_ptr<LatencyHistogram>& callbackUs);
+    static void RunCallback(const TimerEntryPtr& entry, LatencyHistogram& callbackUs);
+
+    std::unordered_map<int, TimerEntryList> fdToTimers_;  // timer_fd to the timers it drives
+    std::unordered_map<uint32_t, int> intervalToFd_;  // interval to the timer_fd of its periodic timers
+    std::unordered_map<uint32_t, TimerEntryPtr> timerToEntries_;  // timer_id to TimerEntry
+    uint64_t registerSeq_;
+    // the list OnTimer walks and its next entry, kept valid by EraseEntry
+    int firingFd_;
+    TimerEntryList::iterator firingNext_;
 
     std::string name_;
     int timeoutMs_;
     std::thread thread_;
     std::unique_ptr<EventReactor> reactor_;
-    std::map<uint32_t, uint32_t> timers_;  // timer_fd to interval
     std::mutex mutex_;
+
+    Mode mode_;
+    int wheelFd_;
+    uint64_t wheelArmedTick_;
+    std::unique_ptr<TimingWheel> wheel_;
+    std::unique_ptr<EventHandler> wheelHandler_;
+    std::vector<WheelNode*> wheelExpired_;
+    std::vector<TimerEntryPtr> wheelFired_;
+
+    TimerExecutor executor_;
+    // outlives the Timer in the callbacks queued to executor_
+    std::shared_ptr<std::atomic<bool>> stopped_;
+
+    int hrFd_;
+    uint64_t hrArmedNs_;
+    uint64_t slackNs_;
+    std::multimap<uint64_t, TimerEntry*> hrQueue_;  // deadline ns to the high resolution timers due then
+    std::unique_ptr<EventHandler> hrHandler_;
+    std::vector<TimerEntryPtr> hrFired_;
+
+    LatencyHistogram latenessUs_;
+    std::shared_ptr<LatencyHistogram> callbackUs_;  // outlives the Timer in the callbacks queued to executor_
+    std::atomic<uint64_t> overruns_;
+    std::atomic<uint64_t> dropped_;
+    // the expiration of the timerfd OnTimer handles, from OnTimerExpiry, reset by OnTimer after each use
+    uint64_t fdScheduledNs_;
+    uint64_t fdOverruns_;
+
+    // lock-free stack of RegisterAsync not yet linked, newest first, drained by the timer thread
+    std::atomic<Submission*> submitted_;
+    std::atomic<uint32_t> submittedNum_;
+    std::unordered_set<uint32_t> unregisteredSubmitted_;  // ids Unregistered before DrainSubmitted, with mutex_
+
+    std::mutex delayMutex_;
+    std::unordered_set<std::shared_ptr<DelayState>> delays_;  // Delays not resumed yet
 };
 
 } // namespace Utils
@@ -20,7 +20,9 @@
 #include "utils_log.h"
 
 #include <vector>
+#include <cerrno>
 #include <cstdio>
+#include <ctime>
 #include <strings.h>
 #include <unistd.h>
 #include <sys/epoll.h>
@@ -29,11 +31,27 @@ namespace OHOS {
 namespace Utils {
 
 static const int EPOLL_MAX_EVENS_INIT = 8;
+static const int EPOLL_MAX_EVENS_LIMIT = 4096;
 static const int HALF_OF_MAX_EVENT = 2;
+static const int LOW_USE_FRACTION = 4;     // a wakeup filling less than a quarter of the buffer
+static const int LOW_USE_ROUNDS_TO_SHRINK = 64;
+static const uint64_t SEC_TO_NANO = 1000000000;
 static const int EPOLL_INVALID_FD = -1;
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28) // 28: since linux 4.5, missing from older headers
+#endif
+
+static uint64_t MonotonicNs()
+{
+    timespec now {0, 0};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * SEC_TO_NANO + static_cast<uint64_t>(now.tv_nsec);
+}
 
 EventDemultiplexer::EventDemultiplexer()
-    : epollFd_(epoll_create1(EPOLL_CLOEXEC)), maxEvents_(EPOLL_MAX_EVENS_INIT), mutex_(), eventHandlers_()
+    : epollFd_(epoll_create1(EPOLL_CLOEXEC)), events_(EPOLL_MAX_EVENS_INIT), lowUseRounds_(0),
+      wakeups_(0), eventNum_(0), maxEventsPerWakeup_(0), dispatchNs_(0), blockedNs_(0),
+      eventBufferSize_(EPOLL_MAX_EVENS_INIT), mutex_(), eventHandlers_()
 {
 }
 
@@ -82,6 +100,11 @@ uint32_t EventDemultiplexer::UpdateEventHandler(EventHandler* handler)
     if (handler != itor->second) {
         return TIMER_ERR_DEAL_FAILED;
     }
+    // an exclusive registration can not be modified
+    if (handler->TriggerMode() & EventReactor::EXCLUSIVE) {
+        (void)Update(EPOLL_CTL_DEL, handler);
+        return Update(EPOLL_CTL_ADD, handler);
+    }
     return Update(EPOLL_CTL_MOD, handler);
 }
 
@@ -98,18 +121,20 @@ uint32_t EventDemultiplexer::RemoveEventHandler(EventHandler* handler)
     }
 
     eventHandlers_.erase(itor);
-    if (static_cast<int>(eventHandlers_.size()) < maxEvents_) {
-        maxEvents_ = eventHandlers_.size() / HALF_OF_MAX_EVENT;
-    }
-
     return Update(EPOLL_CTL_DEL, handler);
 }
 
+size_t EventDemultiplexer::GetHandlerNum()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return eventHandlers_.size();
+}
+
 uint32_t EventDemultiplexer::Update(int operation, EventHandler* handler)
 {
     struct epoll_event event;
     bzero(&event, sizeof(event));
-    event.events   = Reactor2Epoll(handler->Events());
+    event.events   = Reactor2Epoll(handler->Events() | handler->TriggerMode());
     event.data.ptr = reinterpret_cast<void*>(handler);
 
     if (epoll_ctl(epollFd_, operation, handler->GetHandle(), &event) != 0) {
@@ -122,66 +147,138 @@ uint32_t EventDemultiplexer::Update(int operation, EventHandler* handler)
 
 void EventDemultiplexer::Polling(int timeout /* ms */)
 {
-    std::vector<struct epoll_event> epollEvents(maxEvents_);
-    int nfds = epoll_wait(epollFd_, &epollEvents[0], static_cast<int>(epollEvents.size()), timeout);
+    uint64_t begin = MonotonicNs();
+    int nfds = epoll_wait(epollFd_, events_.data(), static_cast<int>(events_.size()), timeout);
+    uint64_t woken = MonotonicNs();
+    Accumulate(blockedNs_, woken - begin);
     if (nfds == 0) {
         return;
     }
     if (nfds == -1) {
-        UTILS_LOGE("epoll_wait failed.");
+        if (errno != EINTR) {
+            UTILS_LOGE("epoll_wait failed.");
+        }
         return;
     }
 
+    if (preDispatch_) {
+        preDispatch_(nfds);
+    }
     for (int idx = 0; idx < nfds; ++idx) {
-        int events = epollEvents[idx].events;
-        void* ptr = epollEvents[idx].data.ptr;
+        int events = events_[idx].events;
+        void* ptr = events_[idx].data.ptr;
         auto handler = reinterpret_cast<EventHandler*>(ptr);
         if (handler != nullptr) {
             handler->HandleEvents(Epoll2Reactor(events));
         }
     }
+    if (postDispatch_) {
+        postDispatch_(nfds);
+    }
 
-    if (nfds == maxEvents_) {
-        maxEvents_ *= HALF_OF_MAX_EVENT;
+    Accumulate(dispatchNs_, MonotonicNs() - woken);
+    Accumulate(wakeups_, 1);
+    Accumulate(eventNum_, static_cast<uint64_t>(nfds));
+    if (static_cast<uint64_t>(nfds) > maxEventsPerWakeup_.load(std::memory_order_relaxed)) {
+        maxEventsPerWakeup_.store(static_cast<uint64_t>(nfds), std::memory_order_relaxed);
     }
+    ResizeEventBuffer(nfds);
 }
 
+// double when a wakeup fills the buffer, halve after many wakeups using little of it
+void EventDemultiplexer::ResizeEventBuffer(int nfds)
+{
+    int size = static_cast<int>(events_.size());
+    if ((nfds == size) && (size < EPOLL_MAX_EVENS_LIMIT)) {
+        size *= HALF_OF_MAX_EVENT;
+        lowUseRounds_ = 0;
+    } else if ((nfds < size / LOW_USE_FRACTION) && (size > EPOLL_MAX_EVENS_INIT)) {
+        if (++lowUseRounds_ < LOW_USE_ROUNDS_TO_SHRINK) {
+            return;
+        }
+        size /= HALF_OF_MAX_EVENT;
+        lowUseRounds_ = 0;
+    } else {
+        lowUseRounds_ = 0;
+        return;
+    }
+    events_.resize(size);
+    events_.shrink_to_fit();
+    eventBufferSize_.store(static_cast<uint64_t>(size), std::memory_order_relaxed);
+}
+
+void EventDemultiplexer::Accumulate(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void EventDemultiplexer::SetDispatchHooks(const DispatchHook& pre, const DispatchHook& post)
+{
+    preDispatch_ = pre;
+    postDispatch_ = post;
+}
+
+LoopMetrics EventDemultiplexer::GetMetrics() const
+{
+    LoopMetrics metrics;
+    metrics.wakeups = wakeups_.load(std::memory_order_relaxed);
+    metrics.events = eventNum_.load(std::memory_order_relaxed);
+    metrics.maxEventsPerWakeup = maxEventsPerWakeup_.load(std::memory_order_relaxed);
+    metrics.dispatchNs = dispatchNs_.load(std::memory_order_relaxed);
+    metrics.blockedNs = blockedNs_.load(std::memory_order_relaxed);
+    metrics.eventBufferSize = eventBufferSize_.load(std::memory_order_relaxed);
+    return metrics;
+}
+
+// every event of the report, e.g. data still readable together with the hang up of the peer
 uint32_t EventDemultiplexer::Epoll2Reactor(uint32_t epollEvents)
 {
-    if ((epollEvents & EPOLLHUP) && !(epollEvents & EPOLLIN)) {
-        return EventReactor::CLOSE_EVENT;
+    uint32_t events = EventReactor::NONE_EVENT;
+    if (epollEvents & EPOLLHUP) {
+        events |= EventReactor::CLOSE_EVENT;
     }
 
     if (epollEvents & EPOLLERR) {
-        return EventReactor::ERROR_EVENT;
+        events |= EventReactor::ERROR_EVENT;
     }
 
     if (epollEvents & (EPOLLIN | EPOLLPRI | EPOLLRDHUP)) {
-        return EventReactor::READ_EVENT;
+        events |= EventReactor::READ_EVENT;
     }
 
     if (epollEvents & EPOLLOUT) {
-        return EventReactor::WRITE_EVENT;
+        events |= EventReactor::WRITE_EVENT;
     }
 
-    return EventReactor::NONE_EVENT;
+    return events;
 }
 
 uint32_t EventDemultiplexer::Reactor2Epoll(uint32_t reactorEvent)
 {
-    switch (reactorEvent) {
-        case EventReactor::NONE_EVENT:
-            return TIMER_ERR_OK;
-        case EventReactor::READ_EVENT:
-            return EPOLLIN | EPOLLPRI;
-        case EventReactor::WRITE_EVENT:
-            return EPOLLOUT;
-        case EventReactor::READ_EVENT | EventReactor::WRITE_EVENT:
-            return EPOLLIN | EPOLLPRI | EPOLLOUT;
-        default:
-            UTILS_LOGD("invalid event %{public}u.", reactorEvent);
-            return TIMER_ERR_DEAL_FAILED;
+    static const uint32_t knownEvents = EventReactor::READ_EVENT | EventReactor::WRITE_EVENT |
+        EventReactor::EDGE_TRIGGER | EventReactor::ONE_SHOT | EventReactor::EXCLUSIVE;
+    if (reactorEvent & ~knownEvents) {
+        UTILS_LOGD("invalid event %{public}u.", reactorEvent);
+    }
+
+    uint32_t epollEvents = 0;
+    if (reactorEvent & EventReactor::READ_EVENT) {
+        epollEvents |= EPOLLIN | EPOLLPRI;
+    }
+    if (reactorEvent & EventReactor::WRITE_EVENT) {
+        epollEvents |= EPOLLOUT;
+    }
+    if (reactorEvent & EventReactor::EDGE_TRIGGER) {
+        epollEvents |= EPOLLET;
+    }
+    if (reactorEvent & EventReactor::ONE_SHOT) {
+        epollEvents |= EPOLLONESHOT;
+    }
+    if (reactorEvent & EventReactor::EXCLUSIVE) {
+        // the kernel accepts no EPOLLPRI with it
+        epollEvents = (epollEvents & ~EPOLLPRI) | EPOLLEXCLUSIVE;
     }
+    return epollEvents;
 }
 
 }
@@ -16,15 +16,30 @@
 #ifndef UTILS_EVENT_DEMULTIPLEXER_H
 #define UTILS_EVENT_DEMULTIPLEXER_H
 
+#include <atomic>
 #include <mutex>
 #include <cstdint>
+#include <functional>
 #include <map>
+#include <vector>
+
+struct epoll_event;
 
 namespace OHOS {
 namespace Utils {
 
 class EventHandler;
 
+// counters of an event loop since StartUp, average events per wakeup is events / wakeups
+struct LoopMetrics {
+    uint64_t wakeups = 0;           // epoll_wait returned events
+    uint64_t events = 0;            // events dispatched
+    uint64_t maxEventsPerWakeup = 0;
+    uint64_t dispatchNs = 0;        // time spent dispatching, hooks included
+    uint64_t blockedNs = 0;         // time spent in epoll_wait
+    uint64_t eventBufferSize = 0;   // current capacity of one epoll_wait
+};
+
 class EventDemultiplexer {
 public:
     EventDemultiplexer();
@@ -35,18 +50,38 @@ public:
     uint32_t StartUp();
     void CleanUp();
 
+    using DispatchHook = std::function<void(int eventNum)>;
+
     void Polling(int timeout);
+    // pre runs before the events of a wakeup are dispatched, post after, e.g. to flush batched writes once
+    void SetDispatchHooks(const DispatchHook& pre, const DispatchHook& post);
+    LoopMetrics GetMetrics() const;
 
     uint32_t UpdateEventHandler(EventHandler* handler);
     uint32_t RemoveEventHandler(EventHandler* handler);
+    size_t GetHandlerNum();
 
 private:
     uint32_t Update(int operation, EventHandler* handler);
     static uint32_t Reactor2Epoll(uint32_t reactorEvent);
     static uint32_t Epoll2Reactor(uint32_t epollEvents);
 
+    void ResizeEventBuffer(int nfds);
+    static void Accumulate(std::atomic<uint64_t>& counter, uint64_t value);
+
     int epollFd_;
-    int maxEvents_;
+    std::vector<struct epoll_event> events_;  // reused by every Polling
+    int lowUseRounds_;
+    DispatchHook preDispatch_;
+    DispatchHook postDispatch_;
+
+    // written by the loop thread only, read by any
+    std::atomic<uint64_t> wakeups_;
+    std::atomic<uint64_t> eventNum_;
+    std::atomic<uint64_t> maxEventsPerWakeup_;
+    std::atomic<uint64_t> dispatchNs_;
+    std::atomic<uint64_t> blockedNs_;
+    std::atomic<uint64_t> eventBufferSize_;
     std::recursive_mutex mutex_;
     std::map<int, EventHandler*> eventHandlers_; // guard by mutex_
 };
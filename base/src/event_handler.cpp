@@ -21,7 +21,7 @@ namespace OHOS {
 namespace Utils {
 
 EventHandler::EventHandler(int fd, EventReactor* r)
-    :fd_(fd), events_(EventReactor::NONE_EVENT), reactor_(r)
+    :fd_(fd), events_(EventReactor::NONE_EVENT), triggerMode_(0), reactor_(r), alive_(std::make_shared<bool>(true))
 {
 }
 
@@ -48,30 +48,56 @@ void EventHandler::DisableAll()
     Update();
 }
 
+void EventHandler::Rearm()
+{
+    Update();
+}
+
 void EventHandler::HandleEvents(uint32_t events)
 {
-    if (events & (EventReactor::CLOSE_EVENT)) {
+    if (eventCallback_) {
+        eventCallback_(events);
+        return;
+    }
+
+    // close and error usually destroy the handler, nothing else of the report is delivered
+    if ((events & EventReactor::CLOSE_EVENT) && !(events & EventReactor::READ_EVENT)) {
         if (closeCallback_) {
             closeCallback_();
         }
+        return;
     }
 
-    if (events & (EventReactor::ERROR_EVENT)) {
+    if (events & EventReactor::ERROR_EVENT) {
         if (errorCallback_) {
             errorCallback_();
         }
+        return;
     }
 
-    if (events & (EventReactor::READ_EVENT)) {
-        if (readCallback_) {
-            readCallback_();
+    if ((triggerMode_ & (EventReactor::EDGE_TRIGGER | EventReactor::ONE_SHOT)) == 0) {
+        // level triggered: one event per report, the other one is reported again
+        if (events & EventReactor::READ_EVENT) {
+            if (readCallback_) {
+                readCallback_();
+            }
+        } else if (events & EventReactor::WRITE_EVENT) {
+            if (writeCallback_) {
+                writeCallback_();
+            }
         }
+        return;
     }
 
-    if (events & (EventReactor::WRITE_EVENT)) {
-        if (writeCallback_) {
-            writeCallback_();
-        }
+    std::shared_ptr<bool> alive = alive_;
+    if ((events & EventReactor::READ_EVENT) && readCallback_) {
+        readCallback_();
+    }
+    if (!*alive) {
+        return;
+    }
+    if ((events & EventReactor::WRITE_EVENT) && (events_ & EventReactor::WRITE_EVENT) && writeCallback_) {
+        writeCallback_();
     }
 }
 
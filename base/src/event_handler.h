@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <functional>
 
 namespace OHOS {
@@ -28,29 +29,50 @@ class EventReactor;
 class EventHandler {
 public:
     using Callback = std::function<void()>;
+    using EventCallback = std::function<void(uint32_t events)>;
 
     EventHandler(int fd, EventReactor* r);
     EventHandler& operator=(const EventHandler&) = delete;
     EventHandler(const EventHandler&) = delete;
     EventHandler& operator=(const EventHandler&&) = delete;
     EventHandler(const EventHandler&&) = delete;
-    ~EventHandler() {}
+    ~EventHandler() { *alive_ = false; }
 
     int GetHandle() const { return (fd_); }
     uint32_t Events() const { return (events_); }
+    uint32_t TriggerMode() const { return (triggerMode_); }
 
     void EnableRead();
     void EnableWrite();
     void DisableWrite();
     void DisableAll();
 
+    /*
+     * mode: EventReactor::EDGE_TRIGGER, ONE_SHOT and EXCLUSIVE combined, 0 is level triggered(default).
+     * applied by the next Enable or Disable call, set it before the first one since an EXCLUSIVE
+     * registration is removed and added again to change.
+     */
+    void SetTriggerMode(uint32_t mode) { triggerMode_ = mode; }
+    // report the enabled events once more, after a ONE_SHOT report
+    void Rearm();
+
     const EventReactor* GetEventReactor() const { return reactor_; }
 
     void SetCloseCallback(const Callback& closeCallback) { closeCallback_ = closeCallback; }
     void SetErrorCallback(const Callback& errorCallback) { errorCallback_ = errorCallback; }
     void SetReadCallback(const Callback& readCallback) { readCallback_ = readCallback; }
     void SetWriteCallback(const Callback& writeCallback) { writeCallback_ = writeCallback; }
+    // receives all the events of one report at once, the callbacks of each event are then not called
+    void SetEventCallback(const EventCallback& eventCallback) { eventCallback_ = eventCallback; }
 
+    /*
+     * Callbacks of each event, one report calls:
+     *     close alone, for a hang up without data left to read;
+     *     otherwise error alone, for an error;
+     *     otherwise read, else write, for level triggered handlers, what is left is reported again;
+     *     otherwise read then write, for EDGE_TRIGGER and ONE_SHOT handlers that are not told twice.
+     * Close and error callbacks may destroy the handler, a read callback too: write is then skipped.
+     */
     void HandleEvents(uint32_t events);
 
 private:
@@ -59,12 +81,15 @@ private:
 private:
     int             fd_;
     uint32_t        events_;
+    uint32_t        triggerMode_;
     EventReactor*   reactor_;
 
     Callback  readCallback_;
     Callback  writeCallback_;
     Callback  closeCallback_;
     Callback  errorCallback_;
+    EventCallback eventCallback_;
+    std::shared_ptr<bool> alive_;  // false once destroyed, checked between two callbacks of one report
 };
 
 }
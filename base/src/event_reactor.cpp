@@ -21,18 +21,34 @@
 
 #include <cstdio>
 #include <unistd.h>
+#include <sys/eventfd.h>
 #include <sys/syscall.h>
 
 namespace OHOS {
 namespace Utils {
 
+static const int INVALID_WAKEUP_FD = -1;
+
 EventReactor::EventReactor()
-    :stopped_(true), demultiplexer_(new EventDemultiplexer())
+    :stopped_(true), demultiplexer_(new EventDemultiplexer()), wakeupFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+    wakeupPending_(false), taskHead_(&taskStub_), taskTail_(&taskStub_)
 {
+    if (wakeupFd_ != INVALID_WAKEUP_FD) {
+        wakeupHandler_.reset(new EventHandler(wakeupFd_, this));
+        wakeupHandler_->SetReadCallback(std::bind(&EventReactor::RunPostedTasks, this));
+    }
 }
 
 EventReactor::~EventReactor()
 {
+    TaskNode* node = nullptr;
+    while ((node = PopTask()) != nullptr) {
+        delete node;
+    }
+    wakeupHandler_.reset();
+    if (wakeupFd_ != INVALID_WAKEUP_FD) {
+        close(wakeupFd_);
+    }
 }
 
 void EventReactor::RemoveEventHandler(EventHandler* handler)
@@ -63,7 +79,17 @@ uint32_t EventReactor::StartUp()
         return ret;
     }
 
+    if (wakeupHandler_ == nullptr) {
+        UTILS_LOGE("create wakeup eventfd failed.");
+        return TIMER_ERR_BADF;
+    }
+    wakeupHandler_->EnableRead();
+
     stopped_ = false;
+    // tasks posted before
+    if (wakeupPending_.load()) {
+        Wakeup();
+    }
     return TIMER_ERR_OK;
 }
 
@@ -71,7 +97,95 @@ void EventReactor::CleanUp()
 {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     for (auto &itor : timerEventHandlers_) {
-        itor->Uninitialize();
+        itor.second->Uninitialize();
+    }
+    if (wakeupHandler_ != nullptr) {
+        wakeupHandler_->DisableAll();
+    }
+}
+
+size_t EventReactor::GetHandlerNum() const
+{
+    return (demultiplexer_ == nullptr) ? 0 : demultiplexer_->GetHandlerNum();
+}
+
+void EventReactor::Post(const Task& task)
+{
+    TaskNode* node = new TaskNode();
+    node->task = task;
+    PushTask(node);
+    if (!wakeupPending_.exchange(true)) {
+        Wakeup();
+    }
+}
+
+void EventReactor::Wakeup()
+{
+    uint64_t one = 1;
+    (void)::write(wakeupFd_, &one, sizeof(one));
+}
+
+void EventReactor::PushTask(TaskNode* node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    TaskNode* prev = taskHead_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+// nullptr if empty, or if the last producer has not linked its node yet, it wakes the loop up again then
+EventReactor::TaskNode* EventReactor::PopTask()
+{
+    TaskNode* tail = taskTail_;
+    TaskNode* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &taskStub_) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        taskTail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+        taskTail_ = next;
+        return tail;
+    }
+    if (tail != taskHead_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    // tail is the only node, put the stub behind it to take it out
+    PushTask(&taskStub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        taskTail_ = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void EventReactor::SetDispatchHooks(const EventDemultiplexer::DispatchHook& pre,
+    const EventDemultiplexer::DispatchHook& post)
+{
+    if (demultiplexer_ != nullptr) {
+        demultiplexer_->SetDispatchHooks(pre, post);
+    }
+}
+
+LoopMetrics EventReactor::GetMetrics() const
+{
+    return (demultiplexer_ == nullptr) ? LoopMetrics() : demultiplexer_->GetMetrics();
+}
+
+void EventReactor::RunPostedTasks()
+{
+    uint64_t count = 0;
+    (void)::read(wakeupFd_, &count, sizeof(count));
+    // before taking the tasks, a task posted from now on writes the eventfd again
+    wakeupPending_.store(false);
+
+    TaskNode* node = nullptr;
+    while ((node = PopTask()) != nullptr) {
+        node->task();
+        delete node;
     }
 }
 
@@ -89,9 +203,11 @@ void EventReactor::RunLoop(int timeout) const
 void EventReactor::StopLoop()
 {
     stopped_ = true;
+    Wakeup();
 }
 
-uint32_t EventReactor::ScheduleTimer(const TimerCallback& cb, uint32_t interval, int& timerFd, bool once)
+uint32_t EventReactor::ScheduleTimer(const TimerCallback& cb, uint32_t interval, int& timerFd, bool once,
+    const TimerObserver& observer)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::shared_ptr<TimerEventHandler> handler = std::make_shared<TimerEventHandler>(this, interval, once);
@@ -99,6 +215,7 @@ uint32_t EventReactor::ScheduleTimer(const TimerCallback& cb, uint32_t interval,
         return TIMER_ERR_INVALID_VALUE;
     }
     handler->SetTimerCallback(cb);
+    handler->SetExpiryObserver(observer);
     uint32_t ret = handler->Initialize();
     if (ret != TIMER_ERR_OK) {
         UTILS_LOGD("ScheduleTimer %{public}d initialize failed", interval);
@@ -106,7 +223,7 @@ uint32_t EventReactor::ScheduleTimer(const TimerCallback& cb, uint32_t interval,
     }
 
     timerFd = handler->GetTimerFd();
-    timerEventHandlers_.push_back(handler);
+    timerEventHandlers_[timerFd] = handler;
     return TIMER_ERR_OK;
 }
 
@@ -114,14 +231,12 @@ void EventReactor::CancelTimer(int timerFd)
 {
     UTILS_LOGD("Cancel timer, timerFd: %{public}d.", timerFd);
     std::lock_guard<std::recursive_mutex> lock(mutex_);
-    auto itor = timerEventHandlers_.begin();
-    for (; itor != timerEventHandlers_.end(); ++itor) {
-        if ((*itor)->GetTimerFd() == timerFd) {
-            (*itor)->Uninitialize();
-            timerEventHandlers_.erase(itor);
-            return;
-        }
+    auto itor = timerEventHandlers_.find(timerFd);
+    if (itor == timerEventHandlers_.end()) {
+        return;
     }
+    itor->second->Uninitialize();
+    timerEventHandlers_.erase(itor);
 }
 
 } // namespace Utils
@@ -17,26 +17,36 @@
 #define UTILS_EVENT_REACTOR_H
 
 #include <sys/types.h>
+#include <atomic>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
-#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "event_demultiplexer.h"
 
 namespace OHOS {
 namespace Utils {
 
-class EventDemultiplexer;
 class EventHandler;
 class TimerEventHandler;
 
 class EventReactor {
 public:
     using TimerCallback = std::function<void(int timerFd)>;
+    using TimerObserver = std::function<void(uint64_t scheduledNs, uint64_t overruns)>;
+    using Task = std::function<void()>;
     static const uint32_t NONE_EVENT  = 0x0000;
     static const uint32_t READ_EVENT  = 0x0001;
     static const uint32_t WRITE_EVENT = 0x0002;
     static const uint32_t CLOSE_EVENT = 0x0004;
     static const uint32_t ERROR_EVENT = 0x0008;
+    // trigger modes of EventHandler::SetTriggerMode, level triggered and persistent without them
+    static const uint32_t EDGE_TRIGGER = 0x0010; // report readiness once per change, read or write until EAGAIN
+    static const uint32_t ONE_SHOT     = 0x0020; // disabled after one report until EventHandler::Rearm
+    static const uint32_t EXCLUSIVE    = 0x0040; // of the loops sharing a fd only one is woken up, not with ONE_SHOT
 
     EventReactor();
     EventReactor(const EventReactor&) = delete;
@@ -49,20 +59,55 @@ public:
     void CleanUp();
 
     void RunLoop(int timeout) const;
+    // from any thread, a loop waiting in epoll_wait is woken up at once
     void StopLoop();
-    bool IsStopped() const { return stopped_; }
+    bool IsStopped() const { return stopped_.load(); }
 
     void UpdateEventHandler(EventHandler* handler);
     void RemoveEventHandler(EventHandler* handler);
+    // handlers registered to the loop, for balancing handlers over several loops
+    size_t GetHandlerNum() const;
+
+    /*
+     * run task in the loop thread, from any thread, tasks of one thread run in the order they are posted.
+     * Post never takes a lock: tasks go through a lock-free queue and one eventfd write wakes the loop up
+     * for all the tasks posted until it takes them. tasks posted before StartUp run once the loop runs,
+     * the ones left when the reactor is destroyed are dropped.
+     */
+    void Post(const Task& task);
+
+    // see EventDemultiplexer::SetDispatchHooks, call before StartUp
+    void SetDispatchHooks(const EventDemultiplexer::DispatchHook& pre, const EventDemultiplexer::DispatchHook& post);
+    LoopMetrics GetMetrics() const;
 
-    uint32_t ScheduleTimer(const TimerCallback& cb, uint32_t interval /* ms */, int& timerFd, bool once);
+    // observer: told when each expiration was due and how many were missed, before cb is called
+    uint32_t ScheduleTimer(const TimerCallback& cb, uint32_t interval /* ms */, int& timerFd, bool once,
+        const TimerObserver& observer = nullptr);
     void CancelTimer(int timerFd);
 
 private:
-    volatile bool stopped_;
+    // node of the intrusive multi-producer single-consumer queue of posted tasks(D. Vyukov)
+    struct TaskNode {
+        Task task;
+        std::atomic<TaskNode*> next {nullptr};
+    };
+
+    void RunPostedTasks();
+    void PushTask(TaskNode* node);
+    TaskNode* PopTask();
+    void Wakeup();
+
+    std::atomic<bool> stopped_;
     std::unique_ptr<EventDemultiplexer> demultiplexer_;
     std::recursive_mutex mutex_;
-    std::list<std::shared_ptr<TimerEventHandler>> timerEventHandlers_;
+    std::unordered_map<int, std::shared_ptr<TimerEventHandler>> timerEventHandlers_;  // timer_fd to handler
+
+    int wakeupFd_;  // eventfd, lives as long as the reactor so that Post never writes to a closed fd
+    std::unique_ptr<EventHandler> wakeupHandler_;
+    std::atomic<bool> wakeupPending_;  // an eventfd write the loop has not taken yet
+    std::atomic<TaskNode*> taskHead_;  // last posted, where producers push
+    TaskNode* taskTail_;  // next to run, only used by the loop thread
+    TaskNode taskStub_;
 };
 
 } // namespace Utils
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "event_reactor_group.h"
+#include "common_timer_errors.h"
+#include "thread_ex.h"
+#include "utils_log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <sched.h>
+#include <sys/prctl.h>
+
+namespace OHOS {
+namespace Utils {
+
+EventReactorGroup::EventReactorGroup(size_t loopNum, Policy policy) : policy_(policy), next_(0)
+{
+    if (loopNum == 0) {
+        loopNum = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for (size_t i = 0; i < loopNum; ++i) {
+        loops_.emplace_back(new EventReactor());
+    }
+}
+
+EventReactorGroup::~EventReactorGroup()
+{
+    Stop();
+}
+
+uint32_t EventReactorGroup::Start(const std::string& name, bool bindCpus)
+{
+    if (IsRunning()) {
+        return TIMER_ERR_DEAL_FAILED;
+    }
+
+    // the cpus allowed to the process, which a container may restrict to a few of the online ones
+    std::vector<int> cpus;
+    if (bindCpus) {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            UTILS_LOGE("get cpu affinity of %{public}s failed, errno: %{public}d.", name.c_str(), errno);
+            return TIMER_ERR_DEAL_FAILED;
+        }
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+
+    // started here rather than in the threads, so that a Stop right after Start can not be missed
+    for (auto& loop : loops_) {
+        uint32_t ret = loop->StartUp();
+        if (ret != TIMER_ERR_OK) {
+            UTILS_LOGE("start event loop of %{public}s failed.", name.c_str());
+            for (auto& started : loops_) {
+                started->CleanUp();
+            }
+            return ret;
+        }
+    }
+    for (size_t i = 0; i < loops_.size(); ++i) {
+        int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()]; // -1: not bound
+        threads_.emplace_back(&EventReactorGroup::LoopMain, this, i, name, cpu);
+    }
+    return TIMER_ERR_OK;
+}
+
+void EventReactorGroup::Stop()
+{
+    if (!IsRunning()) {
+        return;
+    }
+
+    for (auto& loop : loops_) {
+        loop->StopLoop();
+    }
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+EventReactor* EventReactorGroup::Next()
+{
+    size_t start = next_.fetch_add(1, std::memory_order_relaxed);
+    if (policy_ == Policy::ROUND_ROBIN) {
+        return GetLoop(start);
+    }
+
+    // ties go round robin too, so that idle loops fill up evenly
+    EventReactor* least = GetLoop(start);
+    size_t leastNum = least->GetHandlerNum();
+    for (size_t i = 1; i < loops_.size(); ++i) {
+        EventReactor* loop = GetLoop(start + i);
+        size_t num = loop->GetHandlerNum();
+        if (num < leastNum) {
+            least = loop;
+            leastNum = num;
+        }
+    }
+    return least;
+}
+
+void EventReactorGroup::LoopMain(size_t index, const std::string& name, int cpu)
+{
+    std::string suffix = std::to_string(index);
+    std::string threadName = name.substr(0, MAX_THREAD_NAME_LEN - suffix.size()) + suffix;
+    prctl(PR_SET_NAME, threadName.c_str(), 0, 0, 0);
+    if (cpu >= 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+        if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+            UTILS_LOGE("bind %{public}s to cpu %{public}d failed, errno: %{public}d.", threadName.c_str(), cpu, errno);
+        }
+    }
+
+    loops_[index]->RunLoop(-1); // -1: only woken up by events and posted tasks
+    loops_[index]->CleanUp();
+}
+
+} // namespace Utils
+} // namespace OHOS
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_EVENT_REACTOR_GROUP_H
+#define UTILS_EVENT_REACTOR_GROUP_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event_reactor.h"
+
+namespace OHOS {
+namespace Utils {
+
+/*
+ * N event loops, each an EventReactor with its own epoll fd running in its own thread, for I/O on many cores.
+ * A handler belongs to the loop it is created with: EventHandler handler(fd, group.Next()), its callbacks
+ * then always run in that loop's thread. Work for a loop is handed over with Post, from any thread.
+ */
+class EventReactorGroup {
+public:
+    enum class Policy {
+        ROUND_ROBIN,   // Next cycles through the loops
+        LEAST_LOADED,  // Next picks the loop with the fewest handlers
+    };
+
+    // loopNum 0: one loop per online cpu
+    explicit EventReactorGroup(size_t loopNum = 0, Policy policy = Policy::ROUND_ROBIN);
+    EventReactorGroup(const EventReactorGroup&) = delete;
+    EventReactorGroup& operator=(const EventReactorGroup&) = delete;
+    ~EventReactorGroup();
+
+    /*
+     * start the loop threads, named name and their index, name is cut to fit the 15 characters of a thread name.
+     * bindCpus true: loop i is bound to the cpu i % n of the n cpus the process may run on;
+     *               TIMER_ERR_DEAL_FAILED if that cpu set can not be read, a failed bind is logged.
+     */
+    uint32_t Start(const std::string& name, bool bindCpus = false);
+    // stop every loop and join its thread, handlers must be disabled by their owners
+    void Stop();
+    bool IsRunning() const { return !threads_.empty(); }
+
+    size_t Size() const { return loops_.size(); }
+    EventReactor* GetLoop(size_t index) const { return loops_[index % loops_.size()].get(); }
+    // loop for a new handler, following the policy
+    EventReactor* Next();
+    void Post(size_t index, const EventReactor::Task& task) { GetLoop(index)->Post(task); }
+
+private:
+    void LoopMain(size_t index, const std::string& name, int cpu);
+
+    Policy policy_;
+    std::atomic<size_t> next_;
+    std::vector<std::unique_ptr<EventReactor>> loops_;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace Utils
+} // namespace OHOS
+#endif
@@ -14,14 +14,93 @@
  */
 
 #include "thread_pool.h"
+#include "thread_ex.h"
+#include "string_ex.h"
 #include "errors.h"
+#include "utils_log.h"
 
+#include <algorithm>
+#include <fstream>
 #include <memory>
+#include <sched.h>
+#include <dirent.h>
+#include <sys/prctl.h>
 
 namespace OHOS {
 
+namespace {
+const std::string NUMA_NODE_DIR = "/sys/devices/system/node/";
+const std::string NUMA_NODE_PREFIX = "node";
+// 10: ms an idle worker waits on its own queue before trying to steal from other nodes again
+constexpr std::chrono::milliseconds STEAL_RETRY_INTERVAL(10);
+
+// cpu list format of sysfs, e.g. "0-3,8,10-11"
+std::vector<int> ParseCpuList(const std::string& cpuList)
+{
+    std::vector<int> cpus;
+    std::vector<std::string> ranges;
+    SplitStr(cpuList, ",", ranges);
+    for (const auto& range : ranges) {
+        std::vector<std::string> bounds;
+        SplitStr(range, "-", bounds);
+        int first = 0;
+        int last = 0;
+        if (bounds.empty() || !StrToInt(bounds.front(), first) || !StrToInt(bounds.back(), last)) {
+            continue;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// cpus of each online NUMA node, empty if the topology is not exported
+std::vector<std::vector<int>> GetNumaNodes()
+{
+    std::vector<std::vector<int>> nodes;
+    DIR* dir = opendir(NUMA_NODE_DIR.c_str());
+    if (dir == nullptr) {
+        return nodes;
+    }
+
+    std::vector<int> nodeIds;
+    struct dirent* entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string name(entry->d_name);
+        int nodeId = 0;
+        if ((name.compare(0, NUMA_NODE_PREFIX.size(), NUMA_NODE_PREFIX) == 0) &&
+            StrToInt(name.substr(NUMA_NODE_PREFIX.size()), nodeId)) {
+            nodeIds.push_back(nodeId);
+        }
+    }
+    closedir(dir);
+
+    std::sort(nodeIds.begin(), nodeIds.end());
+    for (int nodeId : nodeIds) {
+        std::ifstream file(NUMA_NODE_DIR + NUMA_NODE_PREFIX + std::to_string(nodeId) + "/cpulist");
+        std::string cpuList;
+        if (!file.is_open() || !std::getline(file, cpuList)) {
+            continue;
+        }
+        std::vector<int> cpus = ParseCpuList(cpuList);
+        if (!cpus.empty()) {
+            nodes.push_back(cpus);
+        }
+    }
+    return nodes;
+}
+
+bool IsValidCpu(int cpu)
+{
+    return (cpu >= 0) && (cpu < CPU_SETSIZE);
+}
+} // namespace
+
 ThreadPool::ThreadPool(const std::string& name)
-    : myName_(name), maxTaskNum_(0), running_(false)
+    : myName_(name), perWorkerAffinity_(false), numaAware_(false), maxTaskNum_(0),
+      overloadPolicy_(OverloadPolicy::BLOCK), running_(false), addedTaskNum_(0), takenTaskNum_(0),
+      finishedTaskNum_(0), blockedAddNum_(0), droppedTaskNum_(0), rejectedTaskNum_(0)
 {
 }
 
@@ -32,6 +111,32 @@ ThreadPool::~ThreadPool()
     }
 }
 
+uint32_t ThreadPool::SetCpuAffinity(const std::vector<int>& cpus, bool perWorker)
+{
+    if (!threads_.empty()) {
+        return ERR_INVALID_OPERATION;
+    }
+
+    for (int cpu : cpus) {
+        if (!IsValidCpu(cpu)) {
+            return ERR_INVALID_VALUE;
+        }
+    }
+    cpus_ = cpus;
+    perWorkerAffinity_ = perWorker;
+    return ERR_OK;
+}
+
+uint32_t ThreadPool::SetNumaAware(bool numaAware)
+{
+    if (!threads_.empty()) {
+        return ERR_INVALID_OPERATION;
+    }
+
+    numaAware_ = numaAware;
+    return ERR_OK;
+}
+
 uint32_t ThreadPool::Start(int numThreads)
 {
     if (!threads_.empty()) {
@@ -41,21 +146,79 @@ uint32_t ThreadPool::Start(int numThreads)
     if (numThreads <= 0) {
         return ERR_INVALID_VALUE;
     }
+    PlaceWorkers(numThreads);
     running_ = true;
     threads_.reserve(numThreads);
 
     for (int i = 0; i < numThreads; ++i) {
-        threads_.push_back(std::thread(&ThreadPool::WorkInThread, this));
+        threads_.push_back(std::thread(&ThreadPool::WorkInThread, this, i));
     }
     return ERR_OK;
 }
 
+void ThreadPool::PlaceWorkers(int numThreads)
+{
+    // every node keeps the cpus allowed by SetCpuAffinity, a node without any is skipped
+    std::vector<std::vector<int>> nodes;
+    if (numaAware_) {
+        for (auto& node : GetNumaNodes()) {
+            if (!cpus_.empty()) {
+                node.erase(std::remove_if(node.begin(), node.end(), [this](int cpu) {
+                    return std::find(cpus_.begin(), cpus_.end(), cpu) == cpus_.end();
+                }), node.end());
+            }
+            if (!node.empty()) {
+                nodes.push_back(node);
+            }
+        }
+    }
+    if (nodes.size() <= 1) {
+        // not a NUMA system, one queue shared by all workers
+        nodes.assign(1, cpus_);
+    }
+    if (nodes.size() > static_cast<size_t>(numThreads)) {
+        nodes.resize(numThreads);
+    }
+
+    queues_.clear();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        queues_.push_back(std::make_unique<TaskQueue>());
+    }
+
+    cpuToQueue_.clear();
+    if (queues_.size() > 1) {
+        cpuToQueue_.assign(CPU_SETSIZE, 0);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            for (int cpu : nodes[i]) {
+                cpuToQueue_[cpu] = i;
+            }
+        }
+    }
+
+    workers_.clear();
+    std::vector<size_t> workersOnNode(nodes.size(), 0);
+    int64_t now = Clock::now().time_since_epoch() / std::chrono::nanoseconds(1);
+    for (int i = 0; i < numThreads; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->queueIndex = i % nodes.size();
+        const std::vector<int>& cpus = nodes[worker->queueIndex];
+        if (perWorkerAffinity_ && !cpus.empty()) {
+            worker->cpus.push_back(cpus[workersOnNode[worker->queueIndex]++ % cpus.size()]);
+        } else {
+            worker->cpus = cpus;
+        }
+        worker->busyNs = 0;
+        worker->sinceNs = now;
+        workers_.push_back(std::move(worker));
+    }
+}
+
 void ThreadPool::Stop()
 {
-    {
-        std::unique_lock<std::mutex>  lock(mutex_);
-        running_ = false;
-        hasTaskToDo_.notify_all();
+    running_ = false;
+    for (auto& queue : queues_) {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        queue->hasTaskToDo.notify_all();
     }
 
     for (auto& e : threads_) {
@@ -64,57 +227,244 @@ void ThreadPool::Stop()
 }
 
 void ThreadPool::AddTask(const Task &f)
+{
+    if (AddTask(f, (overloadPolicy_ == OverloadPolicy::BLOCK) ? -1 : 0) != ERR_OK) {
+        UTILS_LOGW("thread pool %{public}s is full, task rejected", myName_.c_str());
+    }
+}
+
+uint32_t ThreadPool::AddTask(const Task &f, int timeoutMs)
 {
     if (threads_.empty()) {
         f();
-    } else {
-        std::unique_lock<std::mutex> lock(mutex_);
-        while (Overloaded()) {
-            acceptNewTask_.wait(lock);
+        return ERR_OK;
+    }
+
+    TaskQueue& queue = *queues_[SelectQueue()];
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    if (Overloaded(queue) && (timeoutMs != 0)) {
+        blockedAddNum_.fetch_add(1, std::memory_order_relaxed);
+        if (timeoutMs < 0) {
+            while (Overloaded(queue)) {
+                queue.acceptNewTask.wait(lock);
+            }
+        } else {
+            queue.acceptNewTask.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                [this, &queue] { return !Overloaded(queue); });
         }
+    }
+
+    if (Overloaded(queue)) {
+        switch (overloadPolicy_.load()) {
+            case OverloadPolicy::CALLER_RUNS:
+                lock.unlock();
+                f();
+                return ERR_OK;
+            case OverloadPolicy::DROP_OLDEST: {
+                auto oldest = std::find_if(queue.tasks.begin(), queue.tasks.end(),
+                    [](const TaskEntry& entry) { return !entry.mustRun; });
+                if (oldest != queue.tasks.end()) {
+                    queue.tasks.erase(oldest);
+                    takenTaskNum_.fetch_add(1, std::memory_order_relaxed);
+                    droppedTaskNum_.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+                // only tasks that must run are queued, nothing to discard
+                rejectedTaskNum_.fetch_add(1, std::memory_order_relaxed);
+                return (timeoutMs == 0) ? ERR_WOULD_BLOCK : ERR_TIMED_OUT;
+            }
+            default:
+                rejectedTaskNum_.fetch_add(1, std::memory_order_relaxed);
+                return (timeoutMs == 0) ? ERR_WOULD_BLOCK : ERR_TIMED_OUT;
+        }
+    }
+
+    queue.tasks.push_back(TaskEntry{f, Clock::now(), false});
+    addedTaskNum_.fetch_add(1, std::memory_order_relaxed);
+    queue.hasTaskToDo.notify_one();
+    return ERR_OK;
+}
+
+bool ThreadPool::AddInternalTask(const Task& f, bool mustRun)
+{
+    if (threads_.empty() || !running_) {
+        if (mustRun) {
+            f();
+        }
+        return mustRun;
+    }
 
-        tasks_.push_back(f);
-        hasTaskToDo_.notify_one();
+    TaskQueue& queue = *queues_[SelectQueue()];
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    if (!mustRun && Overloaded(queue)) {
+        return false;
     }
+    queue.tasks.push_back(TaskEntry{f, Clock::now(), mustRun});
+    addedTaskNum_.fetch_add(1, std::memory_order_relaxed);
+    queue.hasTaskToDo.notify_one();
+    return true;
 }
 
 size_t ThreadPool::GetCurTaskNum()
 {
-    std::unique_lock<std::mutex> lock(mutex_);
-    return tasks_.size();
+    size_t taskNum = 0;
+    for (auto& queue : queues_) {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        taskNum += queue->tasks.size();
+    }
+    return taskNum;
+}
+
+size_t ThreadPool::GetPendingTaskNum() const
+{
+    // taken first, a task taken in between can never make the result negative
+    uint64_t taken = takenTaskNum_.load(std::memory_order_relaxed);
+    uint64_t added = addedTaskNum_.load(std::memory_order_relaxed);
+    return (added > taken) ? static_cast<size_t>(added - taken) : 0;
+}
+
+double ThreadPool::GetWorkerBusyRatio(size_t index) const
+{
+    if (index >= workers_.size()) {
+        return 0;
+    }
+
+    const Worker& worker = *workers_[index];
+    int64_t now = Clock::now().time_since_epoch() / std::chrono::nanoseconds(1);
+    int64_t period = now - worker.sinceNs.load(std::memory_order_relaxed);
+    if (period <= 0) {
+        return 0;
+    }
+    double ratio = static_cast<double>(worker.busyNs.load(std::memory_order_relaxed)) / period;
+    return (ratio < 1) ? ratio : 1;
 }
 
+void ThreadPool::ResetMetrics()
+{
+    // counters of the queue state are not reset, GetPendingTaskNum depends on them
+    finishedTaskNum_ = 0;
+    blockedAddNum_ = 0;
+    droppedTaskNum_ = 0;
+    rejectedTaskNum_ = 0;
+    queueWaitUs_.Reset();
+    runTimeUs_.Reset();
+    int64_t now = Clock::now().time_since_epoch() / std::chrono::nanoseconds(1);
+    for (auto& worker : workers_) {
+        worker->busyNs = 0;
+        worker->sinceNs = now;
+    }
+}
 
-ThreadPool::Task ThreadPool::ScheduleTask()
+size_t ThreadPool::SelectQueue() const
 {
-    std::unique_lock<std::mutex> lock(mutex_);
-    while (tasks_.empty() && running_) {
-        hasTaskToDo_.wait(lock);
+    if (cpuToQueue_.empty()) {
+        return 0;
+    }
+
+    int cpu = sched_getcpu();
+    if (!IsValidCpu(cpu)) {
+        return 0;
+    }
+    return cpuToQueue_[cpu];
+}
+
+void ThreadPool::SetupWorker(size_t index)
+{
+    if (!myName_.empty()) {
+        std::string suffix = std::to_string(index);
+        std::string name = myName_.substr(0, MAX_THREAD_NAME_LEN - suffix.size()) + suffix;
+        prctl(PR_SET_NAME, name.c_str(), 0, 0, 0);
+    }
+
+    const std::vector<int>& cpus = workers_[index]->cpus;
+    if (cpus.empty()) {
+        return;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &cpuSet);
+    }
+    (void)sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+}
+
+ThreadPool::Task ThreadPool::ScheduleTask(size_t queueIndex)
+{
+    TaskQueue& queue = *queues_[queueIndex];
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    while (queue.tasks.empty() && running_) {
+        if (queues_.size() == 1) {
+            queue.hasTaskToDo.wait(lock);
+            continue;
+        }
+        lock.unlock();
+        Task task = StealTask(queueIndex);
+        if (task) {
+            return task;
+        }
+        lock.lock();
+        // tasks added to other nodes meanwhile only notify their own workers, steal again after a while
+        if (queue.tasks.empty() && running_) {
+            queue.hasTaskToDo.wait_for(lock, STEAL_RETRY_INTERVAL);
+        }
     }
 
     Task task;
-    if (!tasks_.empty()) {
-        task = tasks_.front();
-        tasks_.pop_front();
+    if (!queue.tasks.empty()) {
+        task = PopTask(queue);
+    }
+    return task;
+}
 
-        if (maxTaskNum_ > 0) {
-            acceptNewTask_.notify_one();
+ThreadPool::Task ThreadPool::StealTask(size_t queueIndex)
+{
+    Task task;
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        TaskQueue& victim = *queues_[(queueIndex + i) % queues_.size()];
+        // never wait for the lock of other nodes, a busy queue has its own workers
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
         }
+
+        task = PopTask(victim);
+        break;
     }
     return task;
 }
 
-bool ThreadPool::Overloaded() const
+ThreadPool::Task ThreadPool::PopTask(TaskQueue& queue)
+{
+    TaskEntry entry = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    takenTaskNum_.fetch_add(1, std::memory_order_relaxed);
+    queueWaitUs_.Record((Clock::now() - entry.addTime) / std::chrono::microseconds(1));
+
+    if (maxTaskNum_ > 0) {
+        queue.acceptNewTask.notify_one();
+    }
+    return std::move(entry.task);
+}
+
+bool ThreadPool::Overloaded(const TaskQueue& queue) const
 {
-    return (maxTaskNum_ > 0) && (tasks_.size() >= maxTaskNum_);
+    return (maxTaskNum_ > 0) && (queue.tasks.size() >= maxTaskNum_);
 }
 
-void ThreadPool::WorkInThread()
+void ThreadPool::WorkInThread(size_t index)
 {
+    SetupWorker(index);
+    Worker& worker = *workers_[index];
     while (running_) {
-        Task task = ScheduleTask();
+        Task task = ScheduleTask(worker.queueIndex);
         if (task) {
+            Clock::time_point start = Clock::now();
             task();
+            Clock::duration runTime = Clock::now() - start;
+            runTimeUs_.Record(runTime / std::chrono::microseconds(1));
+            worker.busyNs.fetch_add(runTime / std::chrono::nanoseconds(1), std::memory_order_relaxed);
+            finishedTaskNum_.fetch_add(1, std::memory_order_relaxed);
         }
     }
 }
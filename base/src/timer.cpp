@@ -18,19 +18,89 @@
 #include <algorithm>
 #include "common_timer_errors.h"
 #include <atomic>
+#include <unistd.h>
 #include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include "event_handler.h"
+#include "thread_pool.h"
 #include "timer_event_handler.h" /* for INVALID_TIMER_FD */
 #include "utils_log.h"
 namespace OHOS {
 namespace Utils {
 
-Timer::Timer(const std::string& name, int timeoutMs) : name_(name), timeoutMs_(timeoutMs),
-    reactor_(new EventReactor())
+static const uint64_t MILLI_TO_BASE = 1000;
+static const uint64_t NANO_TO_MILLI = 1000000;
+static const uint64_t NANO_TO_MICRO = 1000;
+static const uint64_t NANO_TO_BASE = 1000000000;
+static const uint64_t NO_DEADLINE = UINT64_MAX;
+
+// dispatchState of a TimerEntry
+static const int DISPATCH_IDLE = 0;
+static const int DISPATCH_RUNNING = 1; // queued to or running in the executor
+static const int DISPATCH_RERUN = 2;   // and expired again meanwhile
+
+static uint64_t MonotonicNs()
+{
+    timespec now {0, 0};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * MILLI_TO_BASE * NANO_TO_MILLI + static_cast<uint64_t>(now.tv_nsec);
+}
+
+// wheel ticks are CLOCK_MONOTONIC ms: rounded up when a timer starts, down when ticks are run, never early
+static uint64_t StartTick()
 {
+    return (MonotonicNs() + NANO_TO_MILLI - 1) / NANO_TO_MILLI;
+}
+
+static uint64_t PassedTick()
+{
+    return MonotonicNs() / NANO_TO_MILLI;
+}
+
+Timer::Timer(const std::string& name, int timeoutMs, Mode mode) : registerSeq_(0), firingFd_(INVALID_TIMER_FD),
+    name_(name), timeoutMs_(timeoutMs),
+    reactor_(new EventReactor()), mode_(mode), wheelFd_(INVALID_TIMER_FD), wheelArmedTick_(TimingWheel::NO_EXPIRE),
+    stopped_(std::make_shared<std::atomic<bool>>(false)), hrFd_(INVALID_TIMER_FD), hrArmedNs_(NO_DEADLINE), slackNs_(0),
+    callbackUs_(std::make_shared<LatencyHistogram>()), overruns_(0), dropped_(0), fdScheduledNs_(NO_DEADLINE), fdOverruns_(0),
+    submitted_(nullptr), submittedNum_(0)
+{
+}
+
+Timer::~Timer()
+{
+    if (wheelHandler_ != nullptr) {
+        wheelHandler_->DisableAll();
+    }
+    if (wheelFd_ != INVALID_TIMER_FD) {
+        close(wheelFd_);
+    }
+    if (hrHandler_ != nullptr) {
+        hrHandler_->DisableAll();
+    }
+    if (hrFd_ != INVALID_TIMER_FD) {
+        close(hrFd_);
+    }
+    // queued after Shutdown, never linked
+    Submission* node = submitted_.exchange(nullptr);
+    while (node != nullptr) {
+        Submission* next = node->next;
+        delete node;
+        node = next;
+    }
 }
 
 uint32_t Timer::Setup()
 {
+    if (thread_.joinable()) {
+        UTILS_LOGE("timer is running already");
+        return TIMER_ERR_INVALID_VALUE;
+    }
+    // restarted after Shutdown, the callbacks still queued to executor_ keep the old flag and stay skipped
+    if (stopped_->load()) {
+        std::lock_guard<std::mutex> lock(delayMutex_);
+        stopped_ = std::make_shared<std::atomic<bool>>(false);
+    }
+
     std::thread loop_thread(std::bind(&Timer::MainLoop, this));
     thread_.swap(loop_thread);
 
@@ -39,96 +109,372 @@ uint32_t Timer::Setup()
 
 void Timer::Shutdown(bool useJoin)
 {
-    if (reactor_->IsStopped()) {
+    // not the reactor state, which is still stopped until the thread starts the loop
+    if (stopped_->exchange(true)) {
         UTILS_LOGD("timer has been stopped already");
         return;
     }
 
+    // wakes the loop up, it stops at once whatever timeoutMs is
     reactor_->StopLoop();
-    if (timeoutMs_ == -1) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (intervalToTimers_.empty()) {
-            UTILS_LOGI("no event for epoll wait, use detach to shutdown");
+    if (thread_.joinable()) {
+        if (useJoin) {
+            thread_.join();
+        } else {
             thread_.detach();
-            return;
         }
     }
-    if (!useJoin) {
-        thread_.detach();
-        return;
-    }
-    thread_.join();
+    ResumePendingDelays();
 }
 
 uint32_t Timer::Register(const TimerCallback& callback, uint32_t interval /* ms */, bool once)
 {
     std::lock_guard<std::mutex> lock(mutex_);
-    static std::atomic_uint32_t timerId = 1;
-    int timerFd = once ? INVALID_TIMER_FD : GetTimerFd(interval);
+    TimerEntryPtr entry = CreateEntry(callback, interval, once, UniqueTimerId());
+    if (LinkEntry(entry, (mode_ == Mode::TIMING_WHEEL) ? StartTick() : 0) != TIMER_ERR_OK) {
+        return TIMER_ERR_DEAL_FAILED;
+    }
+    if (mode_ == Mode::TIMING_WHEEL) {
+        ArmWheel();
+    }
+
+    UTILS_LOGD("register timer %{public}u with %{public}u ms interval.", entry->timerId, entry->interval);
+    return entry->timerId;
+}
+
+uint32_t Timer::RegisterBatch(const std::vector<TimerRequest>& requests, std::vector<uint32_t>& timerIds)
+{
+    timerIds.assign(requests.size(), TIMER_ERR_DEAL_FAILED);
+    // the callbacks are copied before the lock is taken
+    std::vector<TimerEntryPtr> entries;
+    entries.reserve(requests.size());
+    for (const TimerRequest& request : requests) {
+        entries.push_back(CreateEntry(request.callback, request.interval, request.once, 0));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t startTick = (mode_ == Mode::TIMING_WHEEL) ? StartTick() : 0;
+    uint32_t ret = TIMER_ERR_OK;
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i]->timerId = UniqueTimerId();
+        if (LinkEntry(entries[i], startTick) != TIMER_ERR_OK) {
+            ret = TIMER_ERR_DEAL_FAILED;
+            continue;
+        }
+        timerIds[i] = entries[i]->timerId;
+    }
+    // wheel_ is still null if the batch is empty or every request failed
+    if ((mode_ == Mode::TIMING_WHEEL) && (wheel_ != nullptr)) {
+        ArmWheel();
+    }
+
+    UTILS_LOGD("register %{public}zu timers in a batch.", requests.size());
+    return ret;
+}
+
+uint32_t Timer::RegisterAsync(const TimerCallback& callback, uint32_t interval /* ms */, bool once)
+{
+    Submission* node = new Submission { CreateEntry(callback, interval, once, NextTimerId()), nullptr };
+    uint32_t timerId = node->entry->timerId;
+    submittedNum_.fetch_add(1);
+    Submission* head = submitted_.load(std::memory_order_relaxed);
+    do {
+        node->next = head;
+    } while (!submitted_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    // only the first of a burst wakes the timer thread up, the others ride on its drain
+    if (head == nullptr) {
+        reactor_->Post(std::bind(&Timer::DrainSubmitted, this));
+    }
+    return timerId;
+}
+
+// in the timer thread, link every queued RegisterAsync under one lock
+void Timer::DrainSubmitted()
+{
+    Submission* node = submitted_.exchange(nullptr, std::memory_order_acquire);
+    Submission* fifo = nullptr;
+    while (node != nullptr) {
+        Submission* next = node->next;
+        node->next = fifo;
+        fifo = node;
+        node = next;
+    }
+    if (fifo == nullptr) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t startTick = (mode_ == Mode::TIMING_WHEEL) ? StartTick() : 0;
+    while (fifo != nullptr) {
+        const TimerEntryPtr& entry = fifo->entry;
+        // ids of RegisterAsync skip the uniqueness check, a clash needs the id counter to wrap around
+        if (unregisteredSubmitted_.erase(entry->timerId) != 0) {
+            UTILS_LOGD("timer %{public}u unregistered before it was linked", entry->timerId);
+        } else if (timerToEntries_.find(entry->timerId) != timerToEntries_.end()) {
+            UTILS_LOGE("timer id %{public}u is in use, async register dropped", entry->timerId);
+        } else if (LinkEntry(entry, startTick) != TIMER_ERR_OK) {
+            UTILS_LOGE("async register timer %{public}u failed", entry->timerId);
+        }
+        submittedNum_.fetch_sub(1);
+        Submission* next = fifo->next;
+        delete fifo;
+        fifo = next;
+    }
+    // nothing queued any more, the ids left were not RegisterAsync ones
+    if (submittedNum_.load() == 0) {
+        unregisteredSubmitted_.clear();
+    }
+    if ((mode_ == Mode::TIMING_WHEEL) && (wheel_ != nullptr)) {
+        ArmWheel();
+    }
+}
+
+// give entry its timerfd and add it to the tables, with mutex_ held, the wheel is armed by the caller
+uint32_t Timer::LinkEntry(const TimerEntryPtr& entry, uint64_t startTick)
+{
+    int timerFd = INVALID_TIMER_FD;
+    if (mode_ == Mode::TIMING_WHEEL) {
+        if (SetupWheel() != TIMER_ERR_OK) {
+            return TIMER_ERR_DEAL_FAILED;
+        }
+        timerFd = wheelFd_;
+    } else if (!entry->once) {
+        timerFd = GetTimerFd(entry->interval);
+    }
     if (timerFd == INVALID_TIMER_FD) {
-        uint32_t ret = DoRegister(std::bind(&Timer::OnTimer, this, std::placeholders::_1), interval, once, timerFd);
+        uint32_t ret = DoRegister(std::bind(&Timer::OnTimer, this, std::placeholders::_1), entry->interval,
+            entry->once, timerFd);
         if (ret != TIMER_ERR_OK) {
-            UTILS_LOGE("do register interval timer %{public}d failed, return %{public}u", interval, ret);
+            UTILS_LOGE("do register interval timer %{public}d failed, return %{public}u", entry->interval, ret);
             return TIMER_ERR_DEAL_FAILED;
         }
     }
 
-    timerId = GetValidId(timerId);
-    while (timerToEntries_.find(timerId) != timerToEntries_.end()) {
-        timerId++;
-        timerId = GetValidId(timerId);
+    entry->timerFd = timerFd;
+    entry->seq = registerSeq_++;
+    timerToEntries_[entry->timerId] = entry;
+    if (mode_ == Mode::TIMING_WHEEL) {
+        wheel_->Add(entry.get(), startTick + entry->interval);
+    } else {
+        TimerEntryList& entryList = fdToTimers_[timerFd];
+        entry->handle = entryList.insert(entryList.end(), entry);
+        if (!entry->once) {
+            intervalToFd_[entry->interval] = timerFd;
+        }
     }
+    return TIMER_ERR_OK;
+}
 
+Timer::TimerEntryPtr Timer::CreateEntry(const TimerCallback& callback, uint32_t interval, bool once, uint32_t timerId)
+{
     TimerEntryPtr entry(new TimerEntry());
-    entry->timerId = timerId++;
+    entry->timerId = timerId;
     entry->interval = interval;
     entry->callback = callback;
     entry->once = once;
-    entry->timerFd = timerFd;
+    entry->timerFd = INVALID_TIMER_FD;
+    entry->seq = 0;
+    return entry;
+}
+
+// lock-free, unique until the counter wraps around
+uint32_t Timer::NextTimerId()
+{
+    static std::atomic_uint32_t timerId = 1;
+    uint32_t id = 0;
+    do {
+        id = timerId.fetch_add(1, std::memory_order_relaxed);
+    } while ((id == 0) || (GetValidId(id) != id));
+    return id;
+}
+
+// an id no registered timer has, with mutex_ held
+uint32_t Timer::UniqueTimerId()
+{
+    uint32_t id = NextTimerId();
+    while (timerToEntries_.find(id) != timerToEntries_.end()) {
+        id = NextTimerId();
+    }
+    return id;
+}
+
+uint64_t Timer::NowNs()
+{
+    return MonotonicNs();
+}
+
+uint32_t Timer::RegisterUs(const TimerCallback& callback, uint64_t intervalUs, bool once)
+{
+    if ((intervalUs == 0) && !once) {
+        UTILS_LOGE("periodic timer of 0us is invalid");
+        return TIMER_ERR_DEAL_FAILED;
+    }
+    return RegisterHighRes(callback, MonotonicNs() + intervalUs * NANO_TO_MICRO, intervalUs * NANO_TO_MICRO, once);
+}
+
+uint32_t Timer::RegisterAt(const TimerCallback& callback, uint64_t deadlineNs)
+{
+    return RegisterHighRes(callback, deadlineNs, 0, true);
+}
 
-    intervalToTimers_[interval].push_back(entry);
+void Timer::ResetMetrics()
+{
+    latenessUs_.Reset();
+    callbackUs_->Reset();
+    overruns_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+}
+
+void Timer::SetSlack(uint64_t slackUs)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    slackNs_ = slackUs * NANO_TO_MICRO;
+}
+
+uint32_t Timer::RegisterHighRes(const TimerCallback& callback, uint64_t deadlineNs, uint64_t periodNs, bool once)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (SetupHighRes() != TIMER_ERR_OK) {
+        return TIMER_ERR_DEAL_FAILED;
+    }
+
+    TimerEntryPtr entry = CreateEntry(callback, static_cast<uint32_t>(periodNs / NANO_TO_MILLI), once, UniqueTimerId());
+    entry->timerFd = hrFd_;
+    entry->seq = registerSeq_++;
     timerToEntries_[entry->timerId] = entry;
+    entry->highRes = true;
+    entry->periodNs = periodNs;
+    entry->hrHandle = hrQueue_.emplace(deadlineNs, entry.get());
+    ArmHighRes();
 
-    UTILS_LOGD("register timer %{public}u with %{public}u ms interval.", entry->timerId, entry->interval);
+    UTILS_LOGD("register high resolution timer %{public}u.", entry->timerId);
     return entry->timerId;
 }
 
 void Timer::Unregister(uint32_t timerId)
 {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (timerToEntries_.find(timerId) == timerToEntries_.end()) {
-        UTILS_LOGD("timer %{public}u does not exist", timerId);
+    if (UnregisterLocked(timerId) || (submittedNum_.load() == 0)) {
         return;
     }
+    // may be a RegisterAsync not linked yet, DrainSubmitted takes mutex_ to link it and skips it then
+    unregisteredSubmitted_.insert(timerId);
+}
 
-    auto entry = timerToEntries_[timerId];
+// false if timerId is not registered, with mutex_ held
+bool Timer::UnregisterLocked(uint32_t timerId)
+{
+    auto itor = timerToEntries_.find(timerId);
+    if (itor == timerToEntries_.end()) {
+        UTILS_LOGD("timer %{public}u does not exist", timerId);
+        return false;
+    }
+
+    TimerEntryPtr entry = itor->second;
+    entry->cancelled.store(true);
     UTILS_LOGD("deregister timer %{public}u with %{public}u ms interval", timerId, entry->interval);
+    // the timerfds of the wheel and of high resolution timers stay armed, an early wakeup finds nothing due
+    if (entry->highRes) {
+        if (entry->hrHandle != hrQueue_.end()) {
+            hrQueue_.erase(entry->hrHandle);
+        }
+        timerToEntries_.erase(itor);
+        return true;
+    }
+    if (mode_ == Mode::TIMING_WHEEL) {
+        wheel_->Remove(entry.get());
+        timerToEntries_.erase(timerId);
+        return true;
+    }
 
-    auto itor = intervalToTimers_[entry->interval].begin();
-    for (; itor != intervalToTimers_[entry->interval].end(); ++itor) {
-        if ((*itor)->timerId == timerId) {
-            UTILS_LOGD("erase timer %{public}u.", timerId);
-            if ((*itor)->once) {
-                reactor_->CancelTimer((*itor)->timerFd);
-                timers_.erase((*itor)->timerFd);
-            }
-            intervalToTimers_[entry->interval].erase(itor);
-            break;
+    EraseEntry(entry);
+    return true;
+}
+
+void Timer::SetExecutor(const TimerExecutor& executor)
+{
+    executor_ = executor;
+}
+
+void Timer::SetExecutor(ThreadPool* pool)
+{
+    if (pool == nullptr) {
+        SetExecutor(TimerExecutor());
+        return;
+    }
+    SetExecutor([this, pool](const TimerCallback& task) {
+        if (pool->TryAddTask(task) != ERR_OK) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+}
+
+bool Timer::DelayAwaiter::Suspend(const TimerCallback& resume)
+{
+    auto state = std::make_shared<DelayState>();
+    state->resume = resume;
+    if (pool_ != nullptr) {
+        ThreadPool* pool = pool_;
+        // never blocks the timer thread on a full pool, nor gets discarded by its overload policy
+        state->resume = [pool, resume] { pool->AddInternalTask(resume, true); };
+    }
+    state->result = &result_;
+
+    Timer& timer = timer_;
+    {
+        // checked under the lock, so a Delay either misses Shutdown or is resumed by it
+        std::lock_guard<std::mutex> lock(timer.delayMutex_);
+        if (timer.stopped_->load()) {
+            result_ = TIMER_ERR_DEAL_FAILED;
+            return false;
+        }
+        timer.delays_.insert(state);
+    }
+    // the coroutine, and this awaiter with it, may be resumed and gone before Register returns
+    uint32_t timerId = timer.Register([&timer, state] {
+        if (state->done.exchange(true)) {
+            return;
         }
+        {
+            std::lock_guard<std::mutex> lock(timer.delayMutex_);
+            timer.delays_.erase(state);
+        }
+        state->resume();
+    }, interval_, true);
+    if (timerId == TIMER_ERR_DEAL_FAILED) {
+        std::lock_guard<std::mutex> lock(timer.delayMutex_);
+        timer.delays_.erase(state);
+        result_ = TIMER_ERR_DEAL_FAILED;
+        return false;
     }
+    return true;
+}
 
-    if (intervalToTimers_[entry->interval].empty()) {
-        UTILS_LOGD("deregister timer interval: %{public}u.", entry->interval);
-        intervalToTimers_.erase(entry->interval);
-        DoUnregister(entry->interval);
+// resume the Delays whose timer has not fired, in the calling thread or their pool
+void Timer::ResumePendingDelays()
+{
+    std::unordered_set<std::shared_ptr<DelayState>> delays;
+    {
+        std::lock_guard<std::mutex> lock(delayMutex_);
+        delays.swap(delays_);
+    }
+    for (const auto& state : delays) {
+        if (state->done.exchange(true)) {
+            continue;
+        }
+        *state->result = TIMER_ERR_DEAL_FAILED;
+        state->resume();
     }
-    timerToEntries_.erase(timerId);
 }
 
 void Timer::MainLoop()
 {
     prctl(PR_SET_NAME, name_.c_str(), 0, 0, 0);
-    if (reactor_->StartUp() == TIMER_ERR_OK) {
+    if (slackNs_ != 0) {
+        prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(slackNs_), 0, 0, 0);
+    }
+    // a Shutdown before StartUp found the loop stopped, one after it stops the loop
+    if ((reactor_->StartUp() == TIMER_ERR_OK) && !stopped_->load()) {
         reactor_->RunLoop(timeoutMs_);
     }
     reactor_->CleanUp();
@@ -138,52 +484,346 @@ uint32_t Timer::DoRegister(const TimerListCallback& callback, uint32_t interval,
 {
     using namespace std::placeholders;
     std::function<void(int)> cb = std::bind(&Timer::DoTimerListCallback, this, callback, _1);
-    uint32_t ret = reactor_->ScheduleTimer(cb, interval, timerFd, once);
+    EventReactor::TimerObserver observer = std::bind(&Timer::OnTimerExpiry, this, _1, _2);
+    uint32_t ret = reactor_->ScheduleTimer(cb, interval, timerFd, once, observer);
     if ((ret != TIMER_ERR_OK) || (timerFd < 0)) {
         UTILS_LOGE("ScheduleTimer failed!ret:%{public}d, timerFd:%{public}d", ret, timerFd);
         return ret;
     }
-    timers_[timerFd] = interval;
     return TIMER_ERR_OK;
 }
 
-void Timer::DoUnregister(uint32_t interval)
+void Timer::DoUnregister(int timerFd)
 {
-    for (auto& itor : timers_) {
-        if (itor.second == interval) {
-            reactor_->CancelTimer(itor.first);
+    reactor_->CancelTimer(timerFd);
+}
+
+// unlink entry of a timerfd from the tables in O(1), and release the timerfd with its last entry, with mutex_ held
+void Timer::EraseEntry(const TimerEntryPtr& entry)
+{
+    auto fdItor = fdToTimers_.find(entry->timerFd);
+    if (fdItor != fdToTimers_.end()) {
+        TimerEntryList& entryList = fdItor->second;
+        if ((entry->timerFd == firingFd_) && (entry->handle == firingNext_)) {
+            ++firingNext_;
+        }
+        entryList.erase(entry->handle);
+        if (entryList.empty()) {
+            UTILS_LOGD("deregister timer fd: %{public}d.", entry->timerFd);
+            if (entry->timerFd == firingFd_) {
+                firingFd_ = INVALID_TIMER_FD;
+            }
+            fdToTimers_.erase(fdItor);
+            if (!entry->once) {
+                intervalToFd_.erase(entry->interval);
+            }
+            DoUnregister(entry->timerFd);
         }
     }
+    timerToEntries_.erase(entry->timerId);
+}
+
+// in the timer thread right before OnTimer of the same expiration
+void Timer::OnTimerExpiry(uint64_t scheduledNs, uint64_t overruns)
+{
+    fdScheduledNs_ = scheduledNs;
+    fdOverruns_ = overruns;
 }
 
 void Timer::OnTimer(int timerFd)
 {
-    uint32_t interval = timers_[timerFd];
-    TimerEntryList entryList;
+    // taken once, NO_DEADLINE if the timerfd read failed and OnTimerExpiry was skipped
+    uint64_t scheduledNs = fdScheduledNs_;
+    uint64_t overruns = fdOverruns_;
+    fdScheduledNs_ = NO_DEADLINE;
+    fdOverruns_ = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto fdItor = fdToTimers_.find(timerFd);
+    if (fdItor == fdToTimers_.end()) {
+        return;
+    }
+
+    // walk the list in place, dropping the lock for every callback, timers registered meanwhile wait for the next time
+    TimerEntryList* entryList = &fdItor->second;
+    uint64_t lastSeq = registerSeq_;
+    firingFd_ = timerFd;
+    firingNext_ = entryList->begin();
+    while ((firingFd_ == timerFd) && (firingNext_ != entryList->end()) && ((*firingNext_)->seq < lastSeq)) {
+        TimerEntryPtr entry = *firingNext_;
+        ++firingNext_;
+        lock.unlock();
+        Dispatch(entry, scheduledNs, overruns);
+        lock.lock();
+
+        if (entry->once && !entry->cancelled.load()) {
+            EraseEntry(entry);
+        }
+    }
+    if (firingFd_ == timerFd) {
+        firingFd_ = INVALID_TIMER_FD;
+    }
+}
+
+uint32_t Timer::SetupWheel()
+{
+    if (wheel_ != nullptr) {
+        return TIMER_ERR_OK;
+    }
+
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd == INVALID_TIMER_FD) {
+        UTILS_LOGE("create timerfd of timing wheel failed.");
+        return TIMER_ERR_BADF;
+    }
+    wheelFd_ = timerFd;
+    wheel_.reset(new TimingWheel(PassedTick()));
+    wheelHandler_.reset(new EventHandler(wheelFd_, reactor_.get()));
+    wheelHandler_->SetReadCallback(std::bind(&Timer::OnWheelTimer, this));
+    wheelHandler_->EnableRead();
+    return TIMER_ERR_OK;
+}
+
+// arm the timerfd at the next tick the wheel has work at, with mutex_ held
+void Timer::ArmWheel()
+{
+    uint64_t next = wheel_->NextExpire();
+    if (next == wheelArmedTick_) {
+        return;
+    }
+
+    struct itimerspec newValue = {{0, 0}, {0, 0}}; // disarmed if the wheel is empty
+    if (next != TimingWheel::NO_EXPIRE) {
+        newValue.it_value.tv_sec = static_cast<time_t>(next / MILLI_TO_BASE);
+        newValue.it_value.tv_nsec = static_cast<long>((next % MILLI_TO_BASE) * NANO_TO_MILLI);
+    }
+    if (timerfd_settime(wheelFd_, TFD_TIMER_ABSTIME, &newValue, nullptr) == -1) {
+        UTILS_LOGE("arm timerfd of timing wheel failed.");
+        return;
+    }
+    wheelArmedTick_ = next;
+}
+
+void Timer::OnWheelTimer()
+{
+    uint64_t expirations = 0;
+    (void)::read(wheelFd_, &expirations, sizeof(expirations));
+
+    wheelFired_.clear();
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        entryList = intervalToTimers_[interval];
+        uint64_t now = PassedTick();
+        wheelExpired_.clear();
+        wheel_->Advance(now, wheelExpired_);
+        for (WheelNode* node : wheelExpired_) {
+            auto entry = static_cast<TimerEntry*>(node);
+            auto itor = timerToEntries_.find(entry->timerId);
+            if (itor == timerToEntries_.end()) {
+                continue;
+            }
+            wheelFired_.push_back(itor->second);
+            entry->firedNs = entry->expire * NANO_TO_MILLI;
+            entry->firedOverruns = 0;
+            if (entry->once) {
+                continue; // still found by Unregister until dispatched
+            }
+
+            // keep the phase of periodic timers, periods missed meanwhile fire only once
+            uint64_t interval = std::max<uint64_t>(entry->interval, 1);
+            uint64_t next = entry->expire + interval;
+            if (next <= now) {
+                entry->firedOverruns = (now - next) / interval + 1;
+                next += entry->firedOverruns * interval;
+            }
+            wheel_->Add(entry, next);
+        }
+        wheelArmedTick_ = TimingWheel::NO_EXPIRE;
+        ArmWheel();
+    }
+
+    for (const TimerEntryPtr& entry : wheelFired_) {
+        Dispatch(entry, entry->firedNs, entry->firedOverruns);
     }
+    EraseFiredOnce(wheelFired_);
+}
 
-    std::vector<uint32_t> onceIdsUnused;
-    for (const TimerEntryPtr& ptr : entryList) {
-        if (ptr->timerFd != timerFd) {
+// once timers dispatched by OnWheelTimer or OnHighResTimer, unless a callback unregistered them meanwhile
+void Timer::EraseFiredOnce(const std::vector<TimerEntryPtr>& fired)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const TimerEntryPtr& entry : fired) {
+        if (!entry->once) {
             continue;
         }
-        /* if stop, callback is forbidden */
-        if (!reactor_->IsStopped()) {
-            ptr->callback();
+        auto itor = timerToEntries_.find(entry->timerId);
+        if ((itor != timerToEntries_.end()) && (itor->second == entry)) {
+            timerToEntries_.erase(itor);
         }
+    }
+}
 
-        if (!ptr->once) {
-            continue;
+uint32_t Timer::SetupHighRes()
+{
+    if (hrHandler_ != nullptr) {
+        return TIMER_ERR_OK;
+    }
+
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd == INVALID_TIMER_FD) {
+        UTILS_LOGE("create timerfd of high resolution timers failed.");
+        return TIMER_ERR_BADF;
+    }
+    hrFd_ = timerFd;
+    hrHandler_.reset(new EventHandler(hrFd_, reactor_.get()));
+    hrHandler_->SetReadCallback(std::bind(&Timer::OnHighResTimer, this));
+    hrHandler_->EnableRead();
+    return TIMER_ERR_OK;
+}
+
+// arm the timerfd at the earliest deadline plus slack, all deadlines up to there share one wakeup, with mutex_ held
+void Timer::ArmHighRes()
+{
+    uint64_t next = NO_DEADLINE;
+    if (!hrQueue_.empty()) {
+        next = hrQueue_.begin()->first;
+        next = (next > NO_DEADLINE - slackNs_) ? NO_DEADLINE - 1 : next + slackNs_;
+    }
+    if (next == hrArmedNs_) {
+        return;
+    }
+
+    struct itimerspec newValue = {{0, 0}, {0, 0}}; // disarmed if no timer is waiting
+    if (next != NO_DEADLINE) {
+        newValue.it_value.tv_sec = static_cast<time_t>(next / NANO_TO_BASE);
+        newValue.it_value.tv_nsec = static_cast<long>(next % NANO_TO_BASE);
+        if ((newValue.it_value.tv_sec == 0) && (newValue.it_value.tv_nsec == 0)) {
+            newValue.it_value.tv_nsec = 1; // 1: all zero would disarm it, a deadline of 0 is long passed anyway
+        }
+    }
+    if (timerfd_settime(hrFd_, TFD_TIMER_ABSTIME, &newValue, nullptr) == -1) {
+        UTILS_LOGE("arm timerfd of high resolution timers failed.");
+        return;
+    }
+    hrArmedNs_ = next;
+}
+
+void Timer::OnHighResTimer()
+{
+    uint64_t expirations = 0;
+    (void)::read(hrFd_, &expirations, sizeof(expirations));
+
+    hrFired_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t now = MonotonicNs();
+        while (!hrQueue_.empty() && (hrQueue_.begin()->first <= now)) {
+            TimerEntry* entry = hrQueue_.begin()->second;
+            uint64_t deadline = hrQueue_.begin()->first;
+            hrQueue_.erase(hrQueue_.begin());
+            auto itor = timerToEntries_.find(entry->timerId);
+            if (itor == timerToEntries_.end()) {
+                continue;
+            }
+            hrFired_.push_back(itor->second);
+            entry->firedNs = deadline;
+            entry->firedOverruns = 0;
+            if (entry->once) {
+                entry->hrHandle = hrQueue_.end();
+                continue; // still found by Unregister until dispatched
+            }
+
+            // keep the phase, periods missed meanwhile fire only once
+            uint64_t next = deadline + entry->periodNs;
+            if (next <= now) {
+                entry->firedOverruns = (now - next) / entry->periodNs + 1;
+                next += entry->firedOverruns * entry->periodNs;
+            }
+            entry->hrHandle = hrQueue_.emplace(next, entry);
         }
-        onceIdsUnused.push_back(ptr->timerId);
+        hrArmedNs_ = NO_DEADLINE;
+        ArmHighRes();
     }
 
-    if (!onceIdsUnused.empty()) {
-        EraseUnusedTimerId(interval, onceIdsUnused);
+    for (const TimerEntryPtr& entry : hrFired_) {
+        Dispatch(entry, entry->firedNs, entry->firedOverruns);
     }
+    EraseFiredOnce(hrFired_);
+}
+
+void Timer::Dispatch(const TimerEntryPtr& entry, uint64_t scheduledNs, uint64_t overruns)
+{
+    /* if stop, callback is forbidden */
+    if (reactor_->IsStopped()) {
+        return;
+    }
+    // unregistered by a callback that ran before it in the same round
+    if (entry->cancelled.load()) {
+        return;
+    }
+    // NO_DEADLINE: the expiration is unknown, nothing to record
+    if (scheduledNs != NO_DEADLINE) {
+        uint64_t now = MonotonicNs();
+        latenessUs_.Record(((now > scheduledNs) ? (now - scheduledNs) : 0) / NANO_TO_MICRO);
+    }
+    if (overruns != 0) {
+        overruns_.fetch_add(overruns, std::memory_order_relaxed);
+    }
+    if (!executor_) {
+        RunCallback(entry, *callbackUs_);
+        return;
+    }
+
+    int state = entry->dispatchState.load();
+    while (state != DISPATCH_RERUN) {
+        int next = (state == DISPATCH_IDLE) ? DISPATCH_RUNNING : DISPATCH_RERUN;
+        if (entry->dispatchState.compare_exchange_weak(state, next)) {
+            break;
+        }
+    }
+    if (state != DISPATCH_IDLE) {
+        return; // the run in flight picks it up
+    }
+
+    // the task must not touch this Timer, it may be destroyed before the task runs
+    std::shared_ptr<std::atomic<bool>> stopped = stopped_;
+    std::shared_ptr<LatencyHistogram> callbackUs = callbackUs_;
+    std::shared_ptr<DispatchGuard> guard = std::make_shared<DispatchGuard>();
+    guard->entry = entry;
+    executor_([guard, stopped, callbackUs] {
+        guard->ran = true;
+        RunSerialized(guard->entry, stopped, callbackUs);
+    });
+}
+
+Timer::DispatchGuard::~DispatchGuard()
+{
+    // dropped by the executor, e.g. rejected by a full ThreadPool, the next expiration is dispatched again
+    if (!ran) {
+        entry->dispatchState.store(DISPATCH_IDLE);
+    }
+}
+
+void Timer::RunSerialized(const TimerEntryPtr& entry, const std::shared_ptr<std::atomic<bool>>& stopped,
+    const std::shared_ptr<LatencyHistogram>& callbackUs)
+{
+    while (true) {
+        if (!stopped->load() && !entry->cancelled.load()) {
+            RunCallback(entry, *callbackUs);
+        }
+        int state = DISPATCH_RUNNING;
+        if (entry->dispatchState.compare_exchange_strong(state, DISPATCH_IDLE)) {
+            return;
+        }
+        // expired again meanwhile, run once more
+        entry->dispatchState.store(DISPATCH_RUNNING);
+    }
+}
+
+void Timer::RunCallback(const TimerEntryPtr& entry, LatencyHistogram& callbackUs)
+{
+    uint64_t begin = MonotonicNs();
+    entry->callback();
+    callbackUs.Record((MonotonicNs() - begin) / NANO_TO_MICRO);
 }
 
 void Timer::DoTimerListCallback(const TimerListCallback& callback, int timerFd)
@@ -205,40 +845,11 @@ uint32_t Timer::GetValidId(uint32_t timerId) const
 
 int Timer::GetTimerFd(uint32_t interval /* ms */)
 {
-    if (intervalToTimers_.find(interval) == intervalToTimers_.end()) {
+    auto itor = intervalToFd_.find(interval);
+    if (itor == intervalToFd_.end()) {
         return INVALID_TIMER_FD;
     }
-    auto &entryList = intervalToTimers_[interval];
-    for (const TimerEntryPtr &ptr : entryList) {
-        if (!ptr->once) {
-            return ptr->timerFd;
-        }
-    }
-    return INVALID_TIMER_FD;
-}
-
-void Timer::EraseUnusedTimerId(uint32_t interval, const std::vector<uint32_t>& unusedIds)
-{
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto &entryList = intervalToTimers_[interval];
-    for (auto itor = entryList.begin(); itor != entryList.end();) {
-        uint32_t id = (*itor)->timerId;
-        if (std::find(unusedIds.begin(), unusedIds.end(), id) == unusedIds.end()) {
-            ++itor;
-            continue;
-        }
-
-        reactor_->CancelTimer((*itor)->timerFd);
-        timers_.erase((*itor)->timerFd);
-        itor = entryList.erase(itor);
-        timerToEntries_.erase(id);
-
-        if (entryList.empty()) {
-            intervalToTimers_.erase(interval);
-            DoUnregister(interval);
-            return;
-        }
-    }
+    return itor->second;
 }
 
 } // namespace Utils
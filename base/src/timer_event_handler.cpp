@@ -34,6 +34,7 @@ TimerEventHandler::TimerEventHandler(EventReactor* p, uint32_t timeout /* ms */,
     : once_(once),
       timerFd_(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
       interval_(timeout),
+      nextExpireNs_(0),
       reactor_(p),
       handler_(new EventHandler(timerFd_, p)),
       callback_()
@@ -82,6 +83,8 @@ uint32_t TimerEventHandler::Initialize()
         UTILS_LOGE("Failed in timerFd_settime");
         return TIMER_ERR_DEAL_FAILED;
     }
+    nextExpireNs_ = static_cast<uint64_t>(newValue.it_value.tv_sec) * NANO_TO_BASE +
+        static_cast<uint64_t>(newValue.it_value.tv_nsec);
 
     handler_->SetReadCallback(std::bind(&TimerEventHandler::TimeOut, this));
     handler_->EnableRead();
@@ -105,6 +108,12 @@ void TimerEventHandler::TimeOut()
     ssize_t n = ::read(timerFd_, &expirations, sizeof(expirations));
     if (n != sizeof(expirations)) {
         UTILS_LOGE("epoll_loop::on_timer() reads %{public}d bytes instead of 8.", static_cast<int>(n));
+    } else if (observer_ && (expirations > 0)) {
+        // the timerfd counts the periods passed since the last read, the last one is handled now
+        uint64_t intervalNs = static_cast<uint64_t>(interval_) * MILLI_TO_NANO;
+        uint64_t scheduledNs = nextExpireNs_ + (expirations - 1) * intervalNs;
+        nextExpireNs_ += expirations * intervalNs;
+        observer_(scheduledNs, expirations - 1);
     }
     if (callback_) {
         callback_(timerFd_);
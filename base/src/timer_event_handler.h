@@ -28,7 +28,9 @@ class EventReactor;
 
 class TimerEventHandler {
     using TimerCallback = std::function<void(int timerFd)>;
-    
+    // CLOCK_MONOTONIC ns the expiration was due at, and the expirations missed before it
+    using ExpiryObserver = std::function<void(uint64_t scheduledNs, uint64_t overruns)>;
+
 public:
     TimerEventHandler(EventReactor* p, uint32_t timeout, bool once);
     ~TimerEventHandler();
@@ -42,6 +44,8 @@ public:
     void Uninitialize();
 
     void SetTimerCallback(const TimerCallback& callback) { callback_ = callback; }
+    // called right before the timer callback
+    void SetExpiryObserver(const ExpiryObserver& observer) { observer_ = observer; }
 
     uint32_t GetInterval() const { return interval_; }
     int GetTimerFd() const { return timerFd_; }
@@ -53,10 +57,12 @@ private:
     bool           once_;
     int            timerFd_;
     uint32_t       interval_;
+    uint64_t       nextExpireNs_;
     EventReactor*  reactor_;
 
     std::unique_ptr<EventHandler> handler_;
     TimerCallback                 callback_;
+    ExpiryObserver                observer_;
 };
 
 } // namespace Utils
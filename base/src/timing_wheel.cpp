@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "timing_wheel.h"
+
+#include <algorithm>
+
+namespace OHOS {
+namespace Utils {
+
+// delays from 2^32 ticks on wait in the last slot reachable and are placed again when it cascades
+static const uint64_t MAX_DELTA = (static_cast<uint64_t>(1) << 32) - 1;
+
+const uint64_t TimingWheel::NO_EXPIRE;
+
+TimingWheel::TimingWheel(uint64_t nowTick) : current_(nowTick), size_(0)
+{
+    for (auto& head : slots_) {
+        head.prev = &head;
+        head.next = &head;
+    }
+    std::fill(std::begin(occupied_), std::end(occupied_), 0);
+}
+
+void TimingWheel::Add(WheelNode* node, uint64_t expireTick)
+{
+    if ((node == nullptr) || node->IsLinked()) {
+        return;
+    }
+    node->expire = expireTick;
+    Place(node);
+    size_++;
+}
+
+void TimingWheel::Remove(WheelNode* node)
+{
+    if ((node == nullptr) || !node->IsLinked()) {
+        return;
+    }
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    WheelNode& head = slots_[node->slot];
+    if (head.next == &head) {
+        occupied_[node->slot / WORD_BITS] &= ~(static_cast<uint64_t>(1) << (node->slot % WORD_BITS));
+    }
+    node->prev = nullptr;
+    node->next = nullptr;
+    size_--;
+}
+
+void TimingWheel::Advance(uint64_t nowTick, std::vector<WheelNode*>& expired)
+{
+    while (current_ <= nowTick) {
+        // jump over the ticks without anything to run or to cascade
+        uint64_t next = NextExpire();
+        if (next > nowTick) {
+            current_ = nowTick + 1;
+            return;
+        }
+        current_ = std::max(current_, next);
+
+        uint32_t index = static_cast<uint32_t>(current_ & (ROOT_SLOTS - 1));
+        if (index == 0) {
+            for (int level = 1; level < LEVEL_NUM; level++) {
+                uint32_t levelIndex = static_cast<uint32_t>((current_ >> ShiftOf(level)) & (LEVEL_SLOTS - 1));
+                Cascade(level, levelIndex);
+                if (levelIndex != 0) {
+                    break;
+                }
+            }
+        }
+
+        WheelNode& head = slots_[index];
+        while (head.next != &head) {
+            WheelNode* node = head.next;
+            Remove(node);
+            expired.push_back(node);
+        }
+        current_++;
+    }
+}
+
+uint64_t TimingWheel::NextExpire() const
+{
+    if (size_ == 0) {
+        return NO_EXPIRE;
+    }
+
+    uint64_t next = NO_EXPIRE;
+    uint32_t rootIndex = static_cast<uint32_t>(current_ & (ROOT_SLOTS - 1));
+    int slot = FindOccupied(0, rootIndex);
+    if (slot >= 0) {
+        next = current_ + ((static_cast<uint32_t>(slot) - rootIndex) & (ROOT_SLOTS - 1));
+    }
+
+    // a slot of an upper level is due when the levels below turn around to it
+    for (int level = 1; level < LEVEL_NUM; level++) {
+        int shift = ShiftOf(level);
+        uint64_t turn = (current_ + (static_cast<uint64_t>(1) << shift) - 1) >> shift;
+        uint32_t index = static_cast<uint32_t>(turn & (LEVEL_SLOTS - 1));
+        slot = FindOccupied(level, index);
+        if (slot >= 0) {
+            uint64_t due = (turn + ((static_cast<uint32_t>(slot) - index) & (LEVEL_SLOTS - 1))) << shift;
+            next = std::min(next, due);
+        }
+    }
+    return next;
+}
+
+void TimingWheel::Place(WheelNode* node)
+{
+    uint64_t expire = std::max(node->expire, current_);
+    uint64_t delta = expire - current_;
+    if (delta > MAX_DELTA) {
+        delta = MAX_DELTA;
+        expire = current_ + MAX_DELTA;
+    }
+
+    int level = 0;
+    while ((level < LEVEL_NUM - 1) && (delta >= (static_cast<uint64_t>(1) << ShiftOf(level + 1)))) {
+        level++;
+    }
+    uint32_t index = static_cast<uint32_t>((expire >> ShiftOf(level)) & (SlotsOf(level) - 1));
+    node->slot = FirstSlotOf(level) + index;
+
+    WheelNode& head = slots_[node->slot];
+    node->prev = head.prev;
+    node->next = &head;
+    head.prev->next = node;
+    head.prev = node;
+    occupied_[node->slot / WORD_BITS] |= static_cast<uint64_t>(1) << (node->slot % WORD_BITS);
+}
+
+void TimingWheel::Cascade(int level, uint32_t index)
+{
+    uint32_t slot = FirstSlotOf(level) + index;
+    WheelNode& head = slots_[slot];
+    if (head.next == &head) {
+        return;
+    }
+
+    // detach the whole list first, a node may be placed back into this very slot
+    WheelNode* node = head.next;
+    head.prev->next = nullptr;
+    head.prev = &head;
+    head.next = &head;
+    occupied_[slot / WORD_BITS] &= ~(static_cast<uint64_t>(1) << (slot % WORD_BITS));
+    while (node != nullptr) {
+        WheelNode* next = node->next;
+        Place(node);
+        node = next;
+    }
+}
+
+int TimingWheel::FindOccupied(int level, uint32_t index) const
+{
+    const uint64_t* words = &occupied_[FirstSlotOf(level) / WORD_BITS];
+    uint32_t wordNum = SlotsOf(level) / WORD_BITS;
+    uint32_t word = index / WORD_BITS;
+    uint32_t bit = index % WORD_BITS;
+
+    uint64_t bits = words[word] & (~static_cast<uint64_t>(0) << bit);
+    for (uint32_t i = 1; i <= wordNum; i++) {
+        if (bits != 0) {
+            return static_cast<int>(word * WORD_BITS + static_cast<uint32_t>(__builtin_ctzll(bits)));
+        }
+        word = (word + 1) % wordNum;
+        bits = words[word];
+        if (i == wordNum) {
+            // back to the first word, only the bits before index are left
+            bits &= (static_cast<uint64_t>(1) << bit) - 1;
+        }
+    }
+    return (bits != 0) ? static_cast<int>(word * WORD_BITS + static_cast<uint32_t>(__builtin_ctzll(bits))) : -1;
+}
+
+} // namespace Utils
+} // namespace OHOS
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_TIMING_WHEEL_H
+#define UTILS_TIMING_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace OHOS {
+namespace Utils {
+
+// intrusive link of an item of the wheel, the owner of the item derives from it
+struct WheelNode {
+    WheelNode* prev = nullptr;
+    WheelNode* next = nullptr;
+    uint64_t expire = 0; // tick
+    uint32_t slot = 0;   // index in all the slots of the wheel
+
+    bool IsLinked() const { return next != nullptr; }
+};
+
+/*
+ * Hierarchical timing wheel counting abstract ticks.
+ *
+ * Level 0 has 256 slots of one tick, levels 1 to 4 have 64 slots each covering a whole turn of
+ * the level below, so 2^32 ticks are reachable. A node sits in the level its remaining delay
+ * falls in and moves down (cascades) when the lower levels wrap around to its slot. Add and
+ * Remove are O(1), Advance costs one step per due slot, idle ticks are skipped at once.
+ * Not thread safe.
+ */
+class TimingWheel {
+public:
+    static const uint64_t NO_EXPIRE = UINT64_MAX;
+
+    explicit TimingWheel(uint64_t nowTick);
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+    ~TimingWheel() {}
+
+    // a tick already passed is due on the next Advance
+    void Add(WheelNode* node, uint64_t expireTick);
+    void Remove(WheelNode* node);
+
+    // unlink every node due up to nowTick and append it to expired, ordered by tick
+    void Advance(uint64_t nowTick, std::vector<WheelNode*>& expired);
+
+    // earliest tick Advance has work at, NO_EXPIRE if empty
+    uint64_t NextExpire() const;
+
+    bool IsEmpty() const { return size_ == 0; }
+    size_t Size() const { return size_; }
+
+private:
+    static const int LEVEL_NUM = 5;
+    static const int ROOT_BITS = 8;
+    static const int LEVEL_BITS = 6;
+    static const uint32_t ROOT_SLOTS = 1 << ROOT_BITS;
+    static const uint32_t LEVEL_SLOTS = 1 << LEVEL_BITS;
+    static const uint32_t SLOT_NUM = ROOT_SLOTS + (LEVEL_NUM - 1) * LEVEL_SLOTS;
+    static const uint32_t WORD_BITS = 64;
+
+    static int ShiftOf(int level) { return (level == 0) ? 0 : (ROOT_BITS + (level - 1) * LEVEL_BITS); }
+    static uint32_t SlotsOf(int level) { return (level == 0) ? ROOT_SLOTS : LEVEL_SLOTS; }
+    static uint32_t FirstSlotOf(int level) { return (level == 0) ? 0 : (ROOT_SLOTS + (level - 1) * LEVEL_SLOTS); }
+
+    void Place(WheelNode* node);
+    void Cascade(int level, uint32_t index);
+    // first non empty slot of level at or after index, turning around, -1 if none
+    int FindOccupied(int level, uint32_t index) const;
+
+    uint64_t current_; // next tick to run
+    size_t size_;
+    WheelNode slots_[SLOT_NUM]; // list heads
+    uint64_t occupied_[SLOT_NUM / WORD_BITS]; // one bit per non empty slot
+};
+
+} // namespace Utils
+} // namespace OHOS
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "concurrent_hash_map.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing::ext;
+using namespace OHOS;
+using namespace std;
+
+class UtilsConcurrentHashMap : public testing::Test {
+};
+
+/*
+ * @tc.name: testNormalFeature001
+ * @tc.desc: single thread test of the SafeMap compatible operations
+ */
+HWTEST_F(UtilsConcurrentHashMap, testNormalFeature001, TestSize.Level0)
+{
+    ConcurrentHashMap<string, int> demoData(10);
+    ASSERT_EQ(demoData.GetShardNum(), 16u);
+    ASSERT_TRUE(demoData.IsEmpty());
+
+    ASSERT_TRUE(demoData.Insert("A", 1));
+    ASSERT_FALSE(demoData.Insert("A", 2));
+    demoData.EnsureInsert("B", 2);
+    demoData.EnsureInsert("B", 3);
+    ASSERT_FALSE(demoData.IsEmpty());
+    ASSERT_EQ(demoData.Size(), 2);
+
+    int value = -1;
+    ASSERT_TRUE(demoData.Find("A", value));
+    ASSERT_EQ(value, 1);
+    ASSERT_TRUE(demoData.Find("B", value));
+    ASSERT_EQ(value, 3);
+    ASSERT_FALSE(demoData.Find("C", value));
+
+    int oldValue = -1;
+    ASSERT_TRUE(demoData.FindOldAndSetNew("A", oldValue, 10));
+    ASSERT_EQ(oldValue, 1);
+    ASSERT_FALSE(demoData.FindOldAndSetNew("C", oldValue, 10));
+    ASSERT_TRUE(demoData.Find("A", value));
+    ASSERT_EQ(value, 10);
+
+    int sum = 0;
+    demoData.Iterate([&sum](const string key, int& value) {
+        sum += value;
+        value = 0;
+    });
+    ASSERT_EQ(sum, 13);
+    ASSERT_TRUE(demoData.Find("B", value));
+    ASSERT_EQ(value, 0);
+
+    demoData.Erase("A");
+    ASSERT_EQ(demoData.Size(), 1);
+    demoData.Clear();
+    ASSERT_TRUE(demoData.IsEmpty());
+}
+
+/*
+ * @tc.name: testComputeIfAbsentAndUpdate001
+ * @tc.desc: single thread test of ComputeIfAbsent and Update
+ */
+HWTEST_F(UtilsConcurrentHashMap, testComputeIfAbsentAndUpdate001, TestSize.Level0)
+{
+    ConcurrentHashMap<int, string> demoData;
+    demoData.Reserve(100);
+    int computed = 0;
+    auto compute = [&computed](const int& key) {
+        computed++;
+        return std::to_string(key);
+    };
+
+    ASSERT_EQ(demoData.ComputeIfAbsent(7, compute), "7");
+    ASSERT_EQ(demoData.ComputeIfAbsent(7, compute), "7");
+    ASSERT_EQ(computed, 1);
+
+    ASSERT_TRUE(demoData.Update(7, [](string& value) { value += "!"; }));
+    ASSERT_FALSE(demoData.Update(8, [](string& value) { value += "!"; }));
+    string value;
+    ASSERT_TRUE(demoData.Find(7, value));
+    ASSERT_EQ(value, "7!");
+    ASSERT_EQ(demoData.Size(), 1);
+}
+
+/*
+ * @tc.name: testConcurrentComputeAndUpdate001
+ * @tc.desc: threads compute and update the same keys at the same time, nothing is computed twice or lost
+ */
+HWTEST_F(UtilsConcurrentHashMap, testConcurrentComputeAndUpdate001, TestSize.Level0)
+{
+    const int threadNum = 8;
+    const int keyNum = 1000;
+    ConcurrentHashMap<int, int> demoData;
+    std::atomic<int> computed(0);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < threadNum; i++) {
+        threads.emplace_back([&demoData, &computed] {
+            for (int key = 0; key < keyNum; key++) {
+                demoData.ComputeIfAbsent(key, [&computed](const int&) {
+                    computed++;
+                    return 0;
+                });
+                demoData.Update(key, [](int& value) { value++; });
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQ(computed.load(), keyNum);
+    ASSERT_EQ(demoData.Size(), keyNum);
+    for (int key = 0; key < keyNum; key++) {
+        int value = -1;
+        ASSERT_TRUE(demoData.Find(key, value));
+        ASSERT_EQ(value, threadNum);
+    }
+}
+
+/*
+ * @tc.name: testConcurrentWriteAndFind001
+ * @tc.desc: writers insert and erase disjoint keys while readers look them up
+ */
+HWTEST_F(UtilsConcurrentHashMap, testConcurrentWriteAndFind001, TestSize.Level0)
+{
+    const int writerNum = 4;
+    const int keysPerWriter = 2000;
+    ConcurrentHashMap<int, int> demoData;
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> writers;
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < writerNum; i++) {
+        readers.emplace_back([&demoData, &stop] {
+            int value = -1;
+            while (!stop) {
+                for (int key = 0; key < writerNum * keysPerWriter; key += 97) { // 97: sparse lookups
+                    if (demoData.Find(key, value)) {
+                        ASSERT_EQ(value, key);
+                    }
+                }
+            }
+        });
+        writers.emplace_back([&demoData, i] {
+            for (int key = i * keysPerWriter; key < (i + 1) * keysPerWriter; key++) {
+                demoData.Insert(key, key);
+            }
+            for (int key = i * keysPerWriter; key < (i + 1) * keysPerWriter; key += 2) { // 2: erase even keys
+                demoData.Erase(key);
+            }
+        });
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+    stop = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    ASSERT_EQ(demoData.Size(), writerNum * keysPerWriter / 2); // 2: odd keys are left
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include "thread_pool.h"
+#include "timer.h"
+#include "common_timer_errors.h"
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <thread>
+
+using namespace testing::ext;
+using namespace OHOS;
+
+class UtilsCoroutineTest : public testing::Test {
+};
+
+namespace {
+// coroutine started at once and destroyed when it finishes
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+DetachedTask RunInPool(ThreadPool& pool, std::thread::id& runner, std::atomic<bool>& done)
+{
+    co_await pool.Schedule();
+    runner = std::this_thread::get_id();
+    done = true;
+}
+
+DetachedTask WaitTimer(Utils::Timer& timer, ThreadPool* pool, std::chrono::steady_clock::duration& elapsed,
+    std::atomic<int>& done)
+{
+    auto begin = std::chrono::steady_clock::now();
+    uint32_t ret = co_await timer.Delay(50, pool);
+    elapsed = std::chrono::steady_clock::now() - begin;
+    if (ret == Utils::TIMER_ERR_OK) {
+        ++done;
+    }
+}
+
+DetachedTask WaitTimerResult(Utils::Timer& timer, uint32_t interval, ThreadPool* pool, uint32_t& result,
+    std::atomic<bool>& done)
+{
+    result = co_await timer.Delay(interval, pool);
+    done = true;
+}
+}
+
+HWTEST_F(UtilsCoroutineTest, testSchedule001, TestSize.Level0)
+{
+    ThreadPool pool;
+    std::thread::id runner;
+    std::atomic<bool> done(false);
+
+    // no thread in the pool, go on in this thread
+    RunInPool(pool, runner, done);
+    EXPECT_TRUE(done);
+    EXPECT_EQ(runner, std::this_thread::get_id());
+
+    pool.Start(1);
+    done = false;
+    RunInPool(pool, runner, done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_TRUE(done);
+    EXPECT_NE(runner, std::this_thread::get_id());
+    pool.Stop();
+}
+
+HWTEST_F(UtilsCoroutineTest, testDelay001, TestSize.Level0)
+{
+    Utils::Timer timer("test_timer");
+    EXPECT_EQ(timer.Setup(), Utils::TIMER_ERR_OK);
+    ThreadPool pool;
+    pool.Start(1);
+
+    // many coroutines suspended at the same time, none of them holds a thread
+    const int coroutineNum = 20;
+    std::atomic<int> done(0);
+    std::chrono::steady_clock::duration elapsed[coroutineNum];
+    for (int i = 0; i < coroutineNum; ++i) {
+        WaitTimer(timer, (i % 2 == 0) ? &pool : nullptr, elapsed[i], done);
+    }
+    EXPECT_EQ(done, 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(done, coroutineNum);
+    for (int i = 0; i < coroutineNum; ++i) {
+        EXPECT_GE(elapsed[i], std::chrono::milliseconds(50));
+    }
+    timer.Shutdown();
+    pool.Stop();
+}
+
+HWTEST_F(UtilsCoroutineTest, testDelay002, TestSize.Level0)
+{
+    // resumed by Shutdown before the timer fires, and at once after it
+    Utils::Timer timer("test_timer");
+    EXPECT_EQ(timer.Setup(), Utils::TIMER_ERR_OK);
+    uint32_t result = Utils::TIMER_ERR_OK;
+    std::atomic<bool> done(false);
+    WaitTimerResult(timer, 10000, nullptr, result, done); // 10000: far beyond the test
+    EXPECT_FALSE(done);
+    timer.Shutdown();
+    EXPECT_TRUE(done);
+    EXPECT_EQ(result, Utils::TIMER_ERR_DEAL_FAILED);
+
+    done = false;
+    result = Utils::TIMER_ERR_OK;
+    WaitTimerResult(timer, 10, nullptr, result, done);
+    EXPECT_TRUE(done);
+    EXPECT_EQ(result, Utils::TIMER_ERR_DEAL_FAILED);
+}
+
+HWTEST_F(UtilsCoroutineTest, testDelay003, TestSize.Level0)
+{
+    // a full pool neither blocks the timer thread nor discards the resumption
+    const ThreadPool::OverloadPolicy policies[] = {ThreadPool::OverloadPolicy::BLOCK,
+        ThreadPool::OverloadPolicy::DROP_OLDEST};
+    for (auto policy : policies) {
+        Utils::Timer timer("test_timer");
+        EXPECT_EQ(timer.Setup(), Utils::TIMER_ERR_OK);
+        ThreadPool pool;
+        pool.SetMaxTaskNum(1);
+        pool.SetOverloadPolicy(policy);
+        pool.Start(1);
+        std::atomic<bool> release(false);
+        pool.AddTask([&release] {
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        while (pool.GetCurTaskNum() != 0) {
+            std::this_thread::yield();
+        }
+        pool.AddTask([] {});
+
+        uint32_t result = Utils::TIMER_ERR_DEAL_FAILED;
+        std::atomic<bool> done(false);
+        std::atomic<bool> fired(false);
+        WaitTimerResult(timer, 10, &pool, result, done);
+        timer.Register([&fired] { fired = true; }, 50, true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        EXPECT_TRUE(fired);
+        if (policy == ThreadPool::OverloadPolicy::DROP_OLDEST) {
+            pool.AddTask([] {});
+        }
+        EXPECT_FALSE(done);
+
+        release = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        EXPECT_TRUE(done);
+        EXPECT_EQ(result, Utils::TIMER_ERR_OK);
+        timer.Shutdown();
+        pool.Stop();
+    }
+}
@@ -0,0 +1,513 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../src/event_reactor_group.h"
+#include "../src/event_handler.h"
+#include "common_timer_errors.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+using namespace testing::ext;
+using namespace OHOS::Utils;
+using namespace std;
+
+class UtilsEventReactorGroupTest : public testing::Test {
+};
+
+namespace {
+// counts down from the loop threads, the test thread waits for zero
+class Latch {
+public:
+    explicit Latch(int count) : count_(count) {}
+
+    void CountDown()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--count_ == 0) {
+            cv_.notify_all();
+        }
+    }
+
+    bool WaitFor(int timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return count_ <= 0; });
+    }
+
+private:
+    int count_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+}
+
+/*
+ * @tc.name: testPost001
+ * @tc.desc: tasks posted to a loop run in order in the thread of that loop, each loop has its own thread
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testPost001, TestSize.Level0)
+{
+    const size_t loopNum = 3;
+    const int taskNum = 100;
+    EventReactorGroup group(loopNum);
+    ASSERT_EQ(loopNum, group.Size());
+    ASSERT_EQ(TIMER_ERR_OK, group.Start("test_loop"));
+    ASSERT_TRUE(group.IsRunning());
+
+    std::vector<std::thread::id> threadIds(loopNum);
+    std::vector<std::vector<int>> order(loopNum);
+    Latch done(loopNum * taskNum);
+    for (int task = 0; task < taskNum; task++) {
+        for (size_t i = 0; i < loopNum; i++) {
+            group.Post(i, [&threadIds, &order, &done, i, task] {
+                threadIds[i] = std::this_thread::get_id();
+                order[i].push_back(task);
+                done.CountDown();
+            });
+        }
+    }
+    ASSERT_TRUE(done.WaitFor(1000));
+
+    for (size_t i = 0; i < loopNum; i++) {
+        EXPECT_NE(std::this_thread::get_id(), threadIds[i]);
+        for (size_t j = i + 1; j < loopNum; j++) {
+            EXPECT_NE(threadIds[i], threadIds[j]);
+        }
+        ASSERT_EQ(static_cast<size_t>(taskNum), order[i].size());
+        for (int task = 0; task < taskNum; task++) {
+            EXPECT_EQ(task, order[i][task]);
+        }
+    }
+
+    // the loops wait with no timeout, Stop wakes them up at once
+    auto begin = std::chrono::steady_clock::now();
+    group.Stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(500));
+    EXPECT_FALSE(group.IsRunning());
+}
+
+/*
+ * @tc.name: testThreadNameAndCpu001
+ * @tc.desc: a long group name is cut so each thread keeps its index, loops are bound to cpus the process may use
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testThreadNameAndCpu001, TestSize.Level0)
+{
+    const size_t loopNum = 3;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+    EventReactorGroup group(loopNum);
+    ASSERT_EQ(TIMER_ERR_OK, group.Start("a_very_long_loop_group_name", true));
+
+    std::vector<std::string> names(loopNum);
+    std::vector<cpu_set_t> cpus(loopNum);
+    Latch done(loopNum);
+    for (size_t i = 0; i < loopNum; i++) {
+        group.Post(i, [&names, &cpus, &done, i] {
+            char name[16] = {0}; // 16: PR_GET_NAME fills up to 16 bytes
+            prctl(PR_GET_NAME, name, 0, 0, 0);
+            names[i] = name;
+            sched_getaffinity(0, sizeof(cpus[i]), &cpus[i]);
+            done.CountDown();
+        });
+    }
+    ASSERT_TRUE(done.WaitFor(1000));
+    group.Stop();
+
+    for (size_t i = 0; i < loopNum; i++) {
+        EXPECT_EQ("a_very_long_lo" + std::to_string(i), names[i]);
+        EXPECT_EQ(1, CPU_COUNT(&cpus[i]));
+        cpu_set_t both;
+        CPU_AND(&both, &cpus[i], &allowed);
+        EXPECT_EQ(1, CPU_COUNT(&both));
+    }
+}
+
+/*
+ * @tc.name: testHandlers001
+ * @tc.desc: handlers spread over the loops least loaded first, their callbacks run in the thread of their loop
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testHandlers001, TestSize.Level0)
+{
+    const size_t loopNum = 2;
+    const int handlerNum = 6;
+    EventReactorGroup group(loopNum, EventReactorGroup::Policy::LEAST_LOADED);
+    ASSERT_EQ(TIMER_ERR_OK, group.Start("test_loop"));
+
+    std::vector<std::thread::id> loopThreads(loopNum);
+    Latch started(loopNum);
+    for (size_t i = 0; i < loopNum; i++) {
+        group.Post(i, [&loopThreads, &started, i] {
+            loopThreads[i] = std::this_thread::get_id();
+            started.CountDown();
+        });
+    }
+    ASSERT_TRUE(started.WaitFor(1000));
+
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<EventHandler>> handlers;
+    std::vector<std::thread::id> handledIn(handlerNum);
+    Latch handled(handlerNum);
+    for (int i = 0; i < handlerNum; i++) {
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ASSERT_NE(-1, fd);
+        fds.push_back(fd);
+        handlers.emplace_back(new EventHandler(fd, group.Next()));
+        handlers.back()->SetReadCallback([fd, i, &handledIn, &handled] {
+            uint64_t value = 0;
+            (void)::read(fd, &value, sizeof(value));
+            handledIn[i] = std::this_thread::get_id();
+            handled.CountDown();
+        });
+        handlers.back()->EnableRead();
+    }
+    EXPECT_EQ(group.GetLoop(0)->GetHandlerNum(), group.GetLoop(1)->GetHandlerNum());
+
+    for (int fd : fds) {
+        uint64_t one = 1;
+        ASSERT_EQ(static_cast<ssize_t>(sizeof(one)), ::write(fd, &one, sizeof(one)));
+    }
+    ASSERT_TRUE(handled.WaitFor(1000));
+    for (int i = 0; i < handlerNum; i++) {
+        const EventReactor* loop = handlers[i]->GetEventReactor();
+        size_t index = (loop == group.GetLoop(0)) ? 0 : 1;
+        EXPECT_EQ(loopThreads[index], handledIn[i]);
+    }
+
+    for (size_t i = 0; i < handlers.size(); i++) {
+        handlers[i]->DisableAll();
+        close(fds[i]);
+    }
+    group.Stop();
+}
+
+/*
+ * @tc.name: testTriggerMode001
+ * @tc.desc: an edge triggered handler is called once per write even though it never reads,
+ *           a one shot handler once until it is rearmed
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testTriggerMode001, TestSize.Level0)
+{
+    EventReactorGroup group(1);
+    ASSERT_EQ(TIMER_ERR_OK, group.Start("test_loop"));
+    int edgeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int oneShotFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ASSERT_NE(-1, edgeFd);
+    ASSERT_NE(-1, oneShotFd);
+    std::atomic<int> edgeCalls(0);
+    std::atomic<int> oneShotCalls(0);
+
+    EventHandler edge(edgeFd, group.Next());
+    edge.SetTriggerMode(EventReactor::EDGE_TRIGGER);
+    edge.SetReadCallback([&edgeCalls] { edgeCalls++; });
+    edge.EnableRead();
+    EventHandler oneShot(oneShotFd, group.Next());
+    oneShot.SetTriggerMode(EventReactor::ONE_SHOT);
+    oneShot.SetReadCallback([&oneShotCalls] { oneShotCalls++; });
+    oneShot.EnableRead();
+
+    uint64_t one = 1;
+    auto writeBoth = [edgeFd, oneShotFd, one] {
+        ASSERT_EQ(static_cast<ssize_t>(sizeof(one)), ::write(edgeFd, &one, sizeof(one)));
+        ASSERT_EQ(static_cast<ssize_t>(sizeof(one)), ::write(oneShotFd, &one, sizeof(one)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // 50: level triggered would spin meanwhile
+    };
+    writeBoth();
+    EXPECT_EQ(1, edgeCalls.load());
+    EXPECT_EQ(1, oneShotCalls.load());
+
+    writeBoth();
+    EXPECT_EQ(2, edgeCalls.load()); // 2: the second write is a new edge
+    EXPECT_EQ(1, oneShotCalls.load());
+    oneShot.Rearm();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(2, oneShotCalls.load()); // 2: still readable once rearmed
+
+    edge.DisableAll();
+    oneShot.DisableAll();
+    group.Stop();
+    close(edgeFd);
+    close(oneShotFd);
+}
+
+/*
+ * @tc.name: testEventMask001
+ * @tc.desc: readable data and the hang up of the peer are delivered in one mask, per event callbacks get read alone
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testEventMask001, TestSize.Level0)
+{
+    EventReactorGroup group(1);
+    ASSERT_EQ(TIMER_ERR_OK, group.Start("test_loop"));
+    int fds[2] = {-1, -1};
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds));
+    ASSERT_EQ(1, ::write(fds[1], "x", 1));
+    close(fds[1]);
+
+    std::atomic<uint32_t> mask(0);
+    Latch reported(1);
+    EventHandler withMask(fds[0], group.Next());
+    withMask.SetTriggerMode(EventReactor::ONE_SHOT);
+    withMask.SetEventCallback([&mask, &reported](uint32_t events) {
+        mask = events;
+        reported.CountDown();
+    });
+    withMask.EnableRead();
+    ASSERT_TRUE(reported.WaitFor(1000));
+    EXPECT_EQ(EventReactor::READ_EVENT | EventReactor::CLOSE_EVENT, mask.load());
+    withMask.DisableAll();
+
+    // the data, then the end of the stream, are read, close is not reported while the fd is readable
+    std::vector<ssize_t> reads;
+    std::atomic<int> closes(0);
+    Latch eof(1);
+    EventHandler perEvent(fds[0], group.Next());
+    perEvent.SetReadCallback([&reads, &eof, &perEvent, fd = fds[0]] {
+        char c = 0;
+        reads.push_back(::read(fd, &c, 1));
+        if (reads.back() == 0) {
+            perEvent.DisableAll();
+            eof.CountDown();
+        }
+    });
+    perEvent.SetCloseCallback([&closes] { closes++; });
+    perEvent.EnableRead();
+    ASSERT_TRUE(eof.WaitFor(1000));
+    ASSERT_EQ(2u, reads.size());
+    EXPECT_EQ(1, reads[0]);
+    EXPECT_EQ(0, closes.load());
+
+    group.Stop();
+    close(fds[0]);
+}
+
+/*
+ * @tc.name: testEventOrder001
+ * @tc.desc: an edge triggered handler gets read and write of one report, write is skipped once read destroyed it
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testEventOrder001, TestSize.Level0)
+{
+    EventReactorGroup group(1);
+    ASSERT_EQ(TIMER_ERR_OK, group.Start("test_loop"));
+    int fds[2] = {-1, -1};
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds));
+
+    std::atomic<int> reads(0);
+    std::atomic<int> writes(0);
+    Latch bothReported(1);
+    EventHandler both(fds[0], group.GetLoop(0));
+    both.SetTriggerMode(EventReactor::EDGE_TRIGGER);
+    both.SetReadCallback([&reads] { reads++; });
+    both.SetWriteCallback([&writes, &bothReported, &both] {
+        writes++;
+        both.DisableAll();
+        bothReported.CountDown();
+    });
+    ASSERT_EQ(1, ::write(fds[1], "x", 1));
+    // enabled in the loop thread, so the first report has both events
+    group.Post(0, [&both] {
+        both.EnableRead();
+        both.EnableWrite();
+    });
+    ASSERT_TRUE(bothReported.WaitFor(1000));
+    EXPECT_EQ(1, reads.load());
+    EXPECT_EQ(1, writes.load());
+
+    std::atomic<int> destroyedWrites(0);
+    Latch destroyed(1);
+    EventHandler* handler = new EventHandler(fds[0], group.GetLoop(0));
+    handler->SetTriggerMode(EventReactor::EDGE_TRIGGER);
+    handler->SetWriteCallback([&destroyedWrites] { destroyedWrites++; });
+    handler->SetReadCallback([handler, &destroyed] {
+        destroyed.CountDown();
+        handler->DisableAll();
+        delete handler;
+    });
+    group.Post(0, [handler] {
+        handler->EnableRead();
+        handler->EnableWrite();
+    });
+    ASSERT_TRUE(destroyed.WaitFor(1000));
+    group.Stop();
+    EXPECT_EQ(0, destroyedWrites.load());
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/*
+ * @tc.name: testExclusive001
+ * @tc.desc: a fd shared by the loops of a group with EXCLUSIVE, a write is handled, handlers may change events
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testExclusive001, TestSize.Level0)
+{
+    const size_t loopNum = 2;
+    EventReactorGroup group(loopNum);
+    ASSERT_EQ(TIMER_ERR_OK, group.Start("test_loop"));
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ASSERT_NE(-1, fd);
+    std::atomic<int> reads(0);
+    std::vector<std::unique_ptr<EventHandler>> handlers;
+    for (size_t i = 0; i < loopNum; i++) {
+        size_t before = group.GetLoop(i)->GetHandlerNum();
+        handlers.emplace_back(new EventHandler(fd, group.GetLoop(i)));
+        handlers.back()->SetTriggerMode(EventReactor::EXCLUSIVE);
+        handlers.back()->SetReadCallback([fd, &reads] {
+            uint64_t value = 0;
+            if (::read(fd, &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value))) {
+                reads++;
+            }
+        });
+        handlers.back()->EnableRead();
+        handlers.back()->EnableWrite(); // re-registered, an exclusive one can not be modified
+        handlers.back()->DisableWrite();
+        EXPECT_EQ(before + 1, group.GetLoop(i)->GetHandlerNum());
+    }
+
+    uint64_t one = 1;
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(one)), ::write(fd, &one, sizeof(one)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(1, reads.load());
+
+    for (auto& handler : handlers) {
+        handler->DisableAll();
+    }
+    group.Stop();
+    close(fd);
+}
+
+/*
+ * @tc.name: testLoopMetrics001
+ * @tc.desc: dispatch hooks wrap every wakeup, the event buffer grows when filled, metrics count it all
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testLoopMetrics001, TestSize.Level0)
+{
+    const int handlerNum = 40;
+    EventReactorGroup group(1);
+    EventReactor* loop = group.GetLoop(0);
+    std::atomic<int> preEvents(0);
+    std::atomic<int> postEvents(0);
+    loop->SetDispatchHooks([&preEvents](int eventNum) { preEvents += eventNum; },
+        [&postEvents](int eventNum) { postEvents += eventNum; });
+    ASSERT_EQ(TIMER_ERR_OK, group.Start("test_loop"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 20: some time blocked in epoll_wait
+
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<EventHandler>> handlers;
+    Latch handled(handlerNum);
+    for (int i = 0; i < handlerNum; i++) {
+        int fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC); // 1: readable at once
+        ASSERT_NE(-1, fd);
+        fds.push_back(fd);
+        handlers.emplace_back(new EventHandler(fd, loop));
+        handlers.back()->SetTriggerMode(EventReactor::ONE_SHOT); // reported once though never read
+        handlers.back()->SetReadCallback([&handled] { handled.CountDown(); });
+    }
+    // all of them ready before the loop looks, more than the initial buffer takes at once
+    Latch enabled(1);
+    loop->Post([&handlers, &enabled] {
+        for (auto& handler : handlers) {
+            handler->EnableRead();
+        }
+        enabled.CountDown();
+    });
+    ASSERT_TRUE(enabled.WaitFor(1000));
+    ASSERT_TRUE(handled.WaitFor(1000));
+    for (size_t i = 0; i < handlers.size(); i++) {
+        handlers[i]->DisableAll();
+        close(fds[i]);
+    }
+    group.Stop(); // the last wakeup is fully counted once the loop is gone
+
+    LoopMetrics metrics = loop->GetMetrics();
+    EXPECT_GE(metrics.events, static_cast<uint64_t>(handlerNum + 1)); // 1: the wakeup of the posted task
+    EXPECT_EQ(metrics.events, static_cast<uint64_t>(preEvents.load()));
+    EXPECT_EQ(metrics.events, static_cast<uint64_t>(postEvents.load()));
+    EXPECT_LT(metrics.wakeups, metrics.events);
+    EXPECT_GT(metrics.maxEventsPerWakeup, 8u); // 8: the initial buffer size, it grew
+    EXPECT_GT(metrics.eventBufferSize, 8u);
+    EXPECT_GE(metrics.blockedNs, 20u * 1000 * 1000); // 20 * 1000 * 1000: the 20ms waiting for work
+    EXPECT_GT(metrics.dispatchNs, 0u);
+}
+
+/*
+ * @tc.name: testPostConcurrent001
+ * @tc.desc: many threads post at once, every task runs exactly once and those of one thread in order
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testPostConcurrent001, TestSize.Level0)
+{
+    const int producerNum = 4;
+    const int taskNum = 10000;
+    EventReactorGroup group(1);
+    EventReactor* loop = group.GetLoop(0);
+    std::vector<int> last(producerNum, -1);
+    std::atomic<int> disorder(0);
+    Latch done(producerNum * taskNum);
+
+    // half of them posted before the loop runs
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producerNum; p++) {
+        producers.emplace_back([loop, p, &last, &disorder, &done] {
+            for (int task = 0; task < taskNum; task++) {
+                loop->Post([p, task, &last, &disorder, &done] {
+                    if (last[p] != task - 1) {
+                        disorder++;
+                    }
+                    last[p] = task;
+                    done.CountDown();
+                });
+            }
+        });
+        if (p == producerNum / 2) { // 2: start the loop in the middle
+            ASSERT_EQ(TIMER_ERR_OK, group.Start("test_loop"));
+        }
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    ASSERT_TRUE(done.WaitFor(5000));
+    EXPECT_EQ(0, disorder.load());
+    group.Stop();
+}
+
+/*
+ * @tc.name: testStopLoop001
+ * @tc.desc: StopLoop wakes up a loop blocked in epoll_wait with no timeout at once
+ */
+HWTEST_F(UtilsEventReactorGroupTest, testStopLoop001, TestSize.Level0)
+{
+    EventReactor loop;
+    ASSERT_EQ(TIMER_ERR_OK, loop.StartUp());
+    std::thread thread([&loop] { loop.RunLoop(-1); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 20: blocked by now
+
+    auto begin = std::chrono::steady_clock::now();
+    loop.StopLoop();
+    thread.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(100));
+    EXPECT_TRUE(loop.IsStopped());
+    loop.CleanUp();
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include "latency_histogram.h"
+#include <thread>
+#include <vector>
+
+using namespace testing::ext;
+using namespace OHOS;
+
+class UtilsLatencyHistogramTest : public testing::Test {
+};
+
+HWTEST_F(UtilsLatencyHistogramTest, testBuckets001, TestSize.Level0)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.GetCount(), 0u);
+    EXPECT_EQ(histogram.GetPercentile(50), 0u);
+
+    histogram.Record(0);
+    histogram.Record(1);
+    histogram.Record(2);
+    histogram.Record(3);
+    histogram.Record(1000);
+    histogram.Record(UINT64_MAX);
+
+    EXPECT_EQ(histogram.GetCount(), 6u);
+    EXPECT_EQ(histogram.GetMax(), UINT64_MAX);
+    EXPECT_EQ(histogram.GetBucketCount(0), 1u);
+    EXPECT_EQ(histogram.GetBucketCount(1), 1u);
+    EXPECT_EQ(histogram.GetBucketCount(2), 2u);
+    EXPECT_EQ(histogram.GetBucketCount(10), 1u); // 1000 in [512, 1024)
+    EXPECT_EQ(histogram.GetBucketCount(LatencyHistogram::BUCKET_NUM - 1), 1u);
+    EXPECT_EQ(LatencyHistogram::GetBucketUpperBound(10), 1023u);
+
+    histogram.Reset();
+    EXPECT_EQ(histogram.GetCount(), 0u);
+    EXPECT_EQ(histogram.GetMax(), 0u);
+    EXPECT_EQ(histogram.GetBucketCount(2), 0u);
+}
+
+HWTEST_F(UtilsLatencyHistogramTest, testPercentile001, TestSize.Level0)
+{
+    LatencyHistogram histogram;
+    for (uint64_t i = 1; i <= 100; ++i) {
+        histogram.Record(i);
+    }
+    EXPECT_EQ(histogram.GetSum(), 5050u);
+    // 50th value is 50, in bucket [32, 64)
+    EXPECT_EQ(histogram.GetPercentile(50), 63u);
+    // 100th value is 100, bucket bound is capped by the max
+    EXPECT_EQ(histogram.GetPercentile(100), 100u);
+    EXPECT_EQ(histogram.GetPercentile(1), 1u);
+}
+
+HWTEST_F(UtilsLatencyHistogramTest, testConcurrent001, TestSize.Level0)
+{
+    LatencyHistogram histogram;
+    const int threadNum = 4;
+    const int recordNum = 10000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadNum; ++i) {
+        threads.emplace_back([&histogram, i] {
+            for (int j = 0; j < recordNum; ++j) {
+                histogram.Record(i * recordNum + j);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(histogram.GetCount(), static_cast<uint64_t>(threadNum * recordNum));
+    EXPECT_EQ(histogram.GetMax(), static_cast<uint64_t>(threadNum * recordNum - 1));
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include "lock_free_block_queue.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing::ext;
+using namespace OHOS;
+using namespace std;
+
+class UtilsLockFreeBlockQueueTest : public testing::Test {
+};
+
+HWTEST_F(UtilsLockFreeBlockQueueTest, testNoWait001, TestSize.Level0)
+{
+    // capacity is rounded up to a power of two
+    LockFreeBlockQueue<string> queue(5);
+    EXPECT_EQ(queue.Capacity(), 8u);
+    EXPECT_TRUE(queue.IsEmpty());
+
+    string out;
+    EXPECT_FALSE(queue.PopNotWait(out));
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(queue.PushNoWait(to_string(i)));
+    }
+    EXPECT_TRUE(queue.IsFull());
+    EXPECT_FALSE(queue.PushNoWait("8"));
+    EXPECT_EQ(queue.Size(), 8u);
+
+    // FIFO, also across the end of the ring
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.PopNotWait(out));
+        EXPECT_EQ(out, to_string(i));
+    }
+    for (int i = 8; i < 12; ++i) {
+        EXPECT_TRUE(queue.PushNoWait(to_string(i)));
+    }
+    for (int i = 4; i < 12; ++i) {
+        EXPECT_EQ(queue.Pop(), to_string(i));
+    }
+    EXPECT_TRUE(queue.IsEmpty());
+}
+
+HWTEST_F(UtilsLockFreeBlockQueueTest, testBlocking001, TestSize.Level0)
+{
+    LockFreeBlockQueue<int> queue(2);
+    atomic<bool> pushed(false);
+    queue.Push(1);
+    queue.Push(2);
+    thread producer([&queue, &pushed] {
+        queue.Push(3); // full, waits for a pop
+        pushed = true;
+    });
+    this_thread::sleep_for(chrono::milliseconds(100));
+    EXPECT_FALSE(pushed);
+    EXPECT_EQ(queue.Pop(), 1);
+    producer.join();
+    EXPECT_TRUE(pushed);
+
+    atomic<int> popped(0);
+    EXPECT_EQ(queue.Pop(), 2);
+    EXPECT_EQ(queue.Pop(), 3);
+    thread consumer([&queue, &popped] {
+        popped = queue.Pop(); // empty, waits for a push
+    });
+    this_thread::sleep_for(chrono::milliseconds(100));
+    EXPECT_EQ(popped, 0);
+    queue.Push(4);
+    consumer.join();
+    EXPECT_EQ(popped, 4);
+}
+
+HWTEST_F(UtilsLockFreeBlockQueueTest, testConcurrent001, TestSize.Level0)
+{
+    const int threadNum = 4;
+    const int elemNum = 20000;
+    LockFreeBlockQueue<int> queue(16);
+    atomic<long long> sum(0);
+    vector<thread> threads;
+    for (int i = 0; i < threadNum; ++i) {
+        threads.emplace_back([&queue] {
+            for (int j = 1; j <= elemNum; ++j) {
+                queue.Push(j);
+            }
+        });
+        threads.emplace_back([&queue, &sum] {
+            for (int j = 0; j < elemNum; ++j) {
+                sum += queue.Pop();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(sum, static_cast<long long>(threadNum) * elemNum * (elemNum + 1) / 2);
+    EXPECT_TRUE(queue.IsEmpty());
+}
+
+HWTEST_F(UtilsLockFreeBlockQueueTest, testDestroy001, TestSize.Level0)
+{
+    // elements left in the queue are destroyed with it
+    auto elem = make_shared<int>(0);
+    {
+        LockFreeBlockQueue<shared_ptr<int>> queue(4);
+        queue.Push(elem);
+        queue.Push(elem);
+        EXPECT_EQ(elem.use_count(), 3);
+        queue.Pop();
+        EXPECT_EQ(elem.use_count(), 2);
+    }
+    EXPECT_EQ(elem.use_count(), 1);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include "parallel_algorithm.h"
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing::ext;
+using namespace OHOS;
+
+class UtilsParallelAlgorithmTest : public testing::Test {
+};
+
+HWTEST_F(UtilsParallelAlgorithmTest, testParallelFor001, TestSize.Level0)
+{
+    ThreadPool pool;
+    pool.Start(4);
+    std::vector<int> values(100000, 0);
+    ParallelFor(pool, 0, values.size(), [&values](size_t i) { values[i] += static_cast<int>(i); });
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], static_cast<int>(i));
+    }
+
+    // empty range and explicit grain
+    ParallelFor(pool, 10, 10, [&values](size_t i) { values[i] = -1; });
+    ParallelFor(pool, 0, 10, [&values](size_t i) { values[i] = -1; }, 3);
+    EXPECT_EQ(values[9], -1);
+    EXPECT_EQ(values[10], 10);
+    pool.Stop();
+}
+
+HWTEST_F(UtilsParallelAlgorithmTest, testParallelFor002, TestSize.Level0)
+{
+    // a pool not started runs everything in the caller
+    ThreadPool pool;
+    std::atomic<int> count(0);
+    ParallelFor(pool, 0, 1000, [&count](size_t) { ++count; });
+    EXPECT_EQ(count, 1000);
+}
+
+HWTEST_F(UtilsParallelAlgorithmTest, testParallelFor003, TestSize.Level0)
+{
+    // nested in a task of the same full pool, the caller does the work
+    ThreadPool pool;
+    pool.Start(1);
+    std::atomic<int> count(0);
+    std::atomic<bool> finished(false);
+    pool.AddTask([&pool, &count, &finished] {
+        ParallelFor(pool, 0, 1000, [&count](size_t) { ++count; });
+        finished = true;
+    });
+    sleep(1);
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(count, 1000);
+    pool.Stop();
+}
+
+HWTEST_F(UtilsParallelAlgorithmTest, testParallelReduce001, TestSize.Level0)
+{
+    ThreadPool pool;
+    pool.Start(4);
+    uint64_t sum = ParallelReduce(pool, 0, 100001, static_cast<uint64_t>(0),
+        [](size_t i) { return static_cast<uint64_t>(i); },
+        [](uint64_t lhs, uint64_t rhs) { return lhs + rhs; });
+    EXPECT_EQ(sum, 5000050000u);
+
+    // not commutative, the order is kept
+    std::string text = ParallelReduce(pool, 0, 26, std::string(),
+        [](size_t i) { return std::string(1, static_cast<char>('a' + i)); },
+        [](const std::string& lhs, const std::string& rhs) { return lhs + rhs; }, 1);
+    EXPECT_EQ(text, "abcdefghijklmnopqrstuvwxyz");
+    pool.Stop();
+}
+
+HWTEST_F(UtilsParallelAlgorithmTest, testParallelSort001, TestSize.Level0)
+{
+    ThreadPool pool;
+    pool.Start(3);
+    std::vector<int> values(100003);
+    srand(0);
+    for (auto& value : values) {
+        value = rand();
+    }
+    std::vector<int> expected(values);
+    std::sort(expected.begin(), expected.end());
+    ParallelSort(pool, values.begin(), values.end());
+    EXPECT_EQ(values, expected);
+
+    ParallelSort(pool, values.begin(), values.end(), std::greater<int>());
+    std::reverse(expected.begin(), expected.end());
+    EXPECT_EQ(values, expected);
+    pool.Stop();
+}
+
+HWTEST_F(UtilsParallelAlgorithmTest, testParallelFor004, TestSize.Level0)
+{
+    // helpers refused by a full pool neither discard queued user tasks nor count as rejections
+    const ThreadPool::OverloadPolicy policies[] = {ThreadPool::OverloadPolicy::DROP_OLDEST,
+        ThreadPool::OverloadPolicy::REJECT};
+    for (auto policy : policies) {
+        ThreadPool pool;
+        pool.SetMaxTaskNum(2);
+        pool.SetOverloadPolicy(policy);
+        pool.Start(2);
+        std::atomic<bool> release(false);
+        std::atomic<int> userRuns(0);
+        for (int i = 0; i < 2; ++i) { // 2: both workers busy
+            pool.AddTask([&release] {
+                while (!release) {
+                    std::this_thread::yield();
+                }
+            });
+        }
+        while (pool.GetCurTaskNum() != 0) {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < 2; ++i) { // 2: the queue is full
+            pool.AddTask([&userRuns] { ++userRuns; });
+        }
+
+        std::atomic<int> count(0);
+        ParallelFor(pool, 0, 1000, [&count](size_t) { ++count; }, 1);
+        EXPECT_EQ(count, 1000);
+        EXPECT_EQ(pool.GetDroppedTaskNum(), 0u);
+        EXPECT_EQ(pool.GetRejectedTaskNum(), 0u);
+        release = true;
+        while (pool.GetFinishedTaskNum() < 4u) { // 4: the two blockers and the two user tasks
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(userRuns, 2);
+        pool.Stop();
+    }
+}
+
+HWTEST_F(UtilsParallelAlgorithmTest, testParallelFor005, TestSize.Level0)
+{
+    // an exception of func is rethrown to the caller once no chunk is running any more
+    ThreadPool pool;
+    pool.Start(2);
+    std::atomic<int> running(0);
+    bool thrown = false;
+    try {
+        ParallelFor(pool, 0, 1000, [&running](size_t index) {
+            ++running;
+            std::this_thread::yield();
+            --running;
+            if (index == 500) { // 500: any index in the middle of the range
+                throw std::runtime_error("failed");
+            }
+        }, 1);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+        EXPECT_EQ(running, 0);
+    }
+    EXPECT_TRUE(thrown);
+
+    // the pool workers survive it
+    std::atomic<int> count(0);
+    ParallelFor(pool, 0, 1000, [&count](size_t) { ++count; }, 1);
+    EXPECT_EQ(count, 1000);
+    pool.Stop();
+}
@@ -16,10 +16,12 @@
 #include "safe_block_queue.h"
 
 #include <array>
+#include <atomic>
 #include <future>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include <iostream>
 
@@ -666,3 +668,125 @@ HWTEST_F(UtilsSafeBlockQueue, testMutilthreadConcurrentGetAndPopInfullqueue001,
         demoDatas[0].Get();
     }
 }
+
+/*
+ * Feature: SafeBlockQueue
+ * Function:Push Pop
+ * SubFunction: NA
+ * FunctionPoints: bursts through a small queue
+ * EnvConditions: NA
+ * CaseDescription: producers and consumers keep blocking on a small queue, no element is lost or duplicated
+ */
+HWTEST_F(UtilsSafeBlockQueue, testMutilthreadProducerConsumerThroughput001, TestSize.Level0)
+{
+    const int capacity = 4;
+    const int threadNum = 2;
+    const int elemsPerThread = 10000;
+    SafeBlockQueue<int> queue(capacity);
+    std::atomic<long long> popedSum(0);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < threadNum; i++) {
+        threads.emplace_back([&queue] {
+            for (int value = 1; value <= elemsPerThread; value++) {
+                queue.Push(value);
+            }
+        });
+        threads.emplace_back([&queue, &popedSum] {
+            for (int count = 0; count < elemsPerThread; count++) {
+                popedSum += queue.Pop();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    long long expected = static_cast<long long>(elemsPerThread) * (elemsPerThread + 1) / 2 * threadNum; // 2: sum
+    ASSERT_EQ(popedSum.load(), expected);
+    ASSERT_TRUE(queue.IsEmpty());
+}
+
+/*
+ * Feature: SafeBlockQueue
+ * Function:PushFor PopFor
+ * SubFunction: NA
+ * FunctionPoints: timed push and pop
+ * EnvConditions: NA
+ * CaseDescription: PopFor on an empty queue and PushFor on a full one give up after the timeout
+ */
+HWTEST_F(UtilsSafeBlockQueue, testTimedPushAndPop001, TestSize.Level0)
+{
+    const int timeoutMs = 50;
+    SafeBlockQueue<int> queue(1);
+    int out = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    ASSERT_FALSE(queue.PopFor(out, std::chrono::milliseconds(timeoutMs)));
+    ASSERT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(timeoutMs));
+
+    ASSERT_TRUE(queue.PushFor(1, std::chrono::milliseconds(timeoutMs)));
+    begin = std::chrono::steady_clock::now();
+    ASSERT_FALSE(queue.PushFor(2, std::chrono::milliseconds(timeoutMs)));
+    ASSERT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(timeoutMs));
+
+    ASSERT_TRUE(queue.PopFor(out, std::chrono::milliseconds(timeoutMs)));
+    ASSERT_EQ(out, 1);
+
+    // a blocked PopFor returns as soon as an element arrives
+    std::thread pusher([&queue] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue.Push(3);
+    });
+    ASSERT_TRUE(queue.PopFor(out, std::chrono::seconds(10)));
+    ASSERT_EQ(out, 3);
+    pusher.join();
+
+    // a timeout beyond the range of the clock waits for ever instead of overflowing
+    std::thread maxPusher([&queue] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ASSERT_TRUE(queue.PushFor(4, std::chrono::milliseconds::max()));
+    });
+    ASSERT_TRUE(queue.PopFor(out, std::chrono::milliseconds::max()));
+    ASSERT_EQ(out, 4);
+    maxPusher.join();
+}
+
+/*
+ * Feature: SafeBlockQueue
+ * Function:Close
+ * SubFunction: NA
+ * FunctionPoints: close wakes up blocked threads
+ * EnvConditions: NA
+ * CaseDescription: Close wakes up blocked Push and Pop, pushes fail afterwards and the elements left can be popped
+ */
+HWTEST_F(UtilsSafeBlockQueue, testClose001, TestSize.Level0)
+{
+    SafeBlockQueue<int> emptyQueue(1);
+    std::thread popper([&emptyQueue] {
+        int out = 0;
+        ASSERT_FALSE(emptyQueue.PopFor(out, std::chrono::seconds(10)));
+        ASSERT_EQ(emptyQueue.Pop(), 0);
+    });
+    SafeBlockQueue<int> fullQueue(1);
+    fullQueue.Push(1);
+    std::thread pusher([&fullQueue] {
+        fullQueue.Push(2);
+        ASSERT_FALSE(fullQueue.PushFor(3, std::chrono::seconds(10)));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto begin = std::chrono::steady_clock::now();
+    emptyQueue.Close();
+    fullQueue.Close();
+    popper.join();
+    pusher.join();
+    ASSERT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(5));
+
+    ASSERT_TRUE(fullQueue.IsClosed());
+    ASSERT_FALSE(fullQueue.PushNoWait(4));
+    int out = 0;
+    ASSERT_TRUE(fullQueue.PopFor(out, std::chrono::milliseconds(0)));
+    ASSERT_EQ(out, 1);
+    ASSERT_FALSE(fullQueue.PopNotWait(out));
+}
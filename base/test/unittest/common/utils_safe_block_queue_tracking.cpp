@@ -690,3 +690,56 @@ HWTEST_F(UtilsSafeBlockQueueTracking, testMutilthreadConcurrentGetAndPopInfullqu
     ASSERT_TRUE(demoDatas[0].joinStatus);
     demoDatas[0].joinStatus = false;
 }
+
+/*
+ * @tc.name: testJoinFor001
+ * @tc.desc: JoinFor gives up after the timeout while tasks are unfinished and succeeds once they are done
+ */
+HWTEST_F(UtilsSafeBlockQueueTracking, testJoinFor001, TestSize.Level0)
+{
+    SafeBlockQueueTracking<int> queue(2);
+    ASSERT_TRUE(queue.PushFor(1, std::chrono::milliseconds(10)));
+    ASSERT_EQ(queue.GetUnfinishTaskNum(), 1);
+    ASSERT_FALSE(queue.JoinFor(std::chrono::milliseconds(50)));
+
+    std::thread worker([&queue] {
+        int out = 0;
+        ASSERT_TRUE(queue.PopFor(out, std::chrono::seconds(10)));
+        queue.OneTaskDone();
+    });
+    ASSERT_TRUE(queue.JoinFor(std::chrono::seconds(10)));
+    worker.join();
+
+    // a timeout beyond the range of the clock waits for ever instead of overflowing
+    ASSERT_TRUE(queue.PushFor(2, std::chrono::milliseconds::max()));
+    std::thread maxWorker([&queue] {
+        int out = 0;
+        ASSERT_TRUE(queue.PopFor(out, std::chrono::milliseconds::max()));
+        queue.OneTaskDone();
+    });
+    ASSERT_TRUE(queue.JoinFor(std::chrono::milliseconds::max()));
+    maxWorker.join();
+}
+
+/*
+ * @tc.name: testCloseWakesJoin001
+ * @tc.desc: Close wakes up Join with tasks left, pushes blocked on the full queue are dropped
+ */
+HWTEST_F(UtilsSafeBlockQueueTracking, testCloseWakesJoin001, TestSize.Level0)
+{
+    SafeBlockQueueTracking<int> queue(1);
+    queue.Push(1);
+    std::thread pusher([&queue] { queue.Push(2); });
+    std::thread joiner([&queue] { queue.Join(); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.Close();
+    joiner.join();
+    pusher.join();
+
+    ASSERT_EQ(queue.GetUnfinishTaskNum(), 1);
+    ASSERT_FALSE(queue.JoinFor(std::chrono::milliseconds(0)));
+    ASSERT_EQ(queue.Pop(), 1);
+    ASSERT_TRUE(queue.OneTaskDone());
+    ASSERT_TRUE(queue.JoinFor(std::chrono::milliseconds(0)));
+}
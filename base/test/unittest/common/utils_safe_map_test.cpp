@@ -443,3 +443,56 @@ HWTEST_F(UtilsSafeMap, testUtilsConcurrentWriteAndFindAndSet001, TestSize.Level0
         }
     });
 }
+
+/*
+ * @tc.name: testUtilsConcurrentAccess001
+ * @tc.desc: 100 threads increase the same value through Access and no increment is lost
+ */
+HWTEST_F(UtilsSafeMap, testUtilsConcurrentAccess001, TestSize.Level0)
+{
+    const int loopNum = 100;
+    SafeMap<string, int> demoData;
+    std::thread threads[THREAD_NUM];
+    for (int i = 0; i < THREAD_NUM; ++i) {
+        threads[i] = std::thread([&demoData] {
+            for (int j = 0; j < loopNum; j++) {
+                demoData.Access("A", [](int& value) { value++; });
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    int tar = -1;
+    ASSERT_TRUE(demoData.Find("A", tar));
+    ASSERT_EQ(tar, THREAD_NUM * loopNum);
+}
+
+/*
+ * @tc.name: testUtilsIterateInBatches001
+ * @tc.desc: IterateInBatches visits every entry once in key order and runs the callback without the lock
+ */
+HWTEST_F(UtilsSafeMap, testUtilsIterateInBatches001, TestSize.Level0)
+{
+    SafeMap<int, int> demoData;
+    for (int i = 0; i < DATA_NUM; i++) {
+        demoData.Insert(i, i);
+    }
+
+    vector<int> keys;
+    demoData.IterateInBatches([&demoData, &keys](const int& key, const int& value) {
+        ASSERT_EQ(key, value);
+        keys.push_back(key);
+        // the lock is not held, writers may go on
+        demoData.EnsureInsert(key, -1);
+    }, 3); // 3: batches of 3 entries
+
+    ASSERT_EQ(keys.size(), static_cast<size_t>(DATA_NUM));
+    for (int i = 0; i < DATA_NUM; i++) {
+        ASSERT_EQ(keys[i], i);
+        int tar = 0;
+        ASSERT_TRUE(demoData.Find(i, tar));
+        ASSERT_EQ(tar, -1);
+    }
+}
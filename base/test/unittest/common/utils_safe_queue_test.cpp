@@ -20,6 +20,8 @@
 #include <iostream>
 #include <thread>
 #include <chrono>   // std::chrono::seconds
+#include <string>
+#include <vector>
 
 using namespace testing::ext;
 using namespace OHOS;
@@ -285,3 +287,46 @@ HWTEST_F(UtilsSafeQueue, testMutilthreadConcurrentGetAndPopInNotEmptyQueue, Test
     putInTestThread.ResetStatus();
     getOutTestThread.ResetStatus();
 }
+
+/*
+ * Feature: SafeQueue, SafeStack
+ * Function: Push by move, Emplace, PushBatch, PopAll
+ */
+HWTEST_F(UtilsSafeQueue, testMoveAndBatch, TestSize.Level0)
+{
+    SafeQueue<std::string> queue;
+    std::string big(1024, 'a');
+    queue.Push(std::move(big));
+    EXPECT_TRUE(big.empty());
+    queue.Emplace(3, 'b');
+    queue.PushBatch(std::vector<std::string>{"c", "d"});
+    std::vector<std::string> more = {"e"};
+    queue.PushBatch(more);
+    EXPECT_EQ(queue.Size(), 5);
+
+    std::string out;
+    ASSERT_TRUE(queue.Pop(out));
+    EXPECT_EQ(out.size(), 1024u);
+
+    std::vector<std::string> all = {"x"};
+    EXPECT_EQ(queue.PopAll(all), 4u);
+    EXPECT_EQ(all, std::vector<std::string>({"x", "bbb", "c", "d", "e"}));
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_EQ(queue.PopAll(all), 0u);
+
+    // stack pops from the back, PopAll keeps the pop order
+    SafeStack<int> stack;
+    stack.PushBatch(std::vector<int>{1, 2, 3});
+    stack.Emplace(4);
+    int top = 0;
+    ASSERT_TRUE(stack.Pop(top));
+    EXPECT_EQ(top, 4);
+    std::vector<int> rest;
+    EXPECT_EQ(stack.PopAll(rest), 3u);
+    EXPECT_EQ(rest, std::vector<int>({3, 2, 1}));
+
+    stack.PushBatch(std::vector<int>{1, 2, 1});
+    int one = 1;
+    stack.Erase(one);
+    EXPECT_EQ(stack.Size(), 1);
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "snapshot_map.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing::ext;
+using namespace OHOS;
+using namespace std;
+
+class UtilsSnapshotMap : public testing::Test {
+};
+
+/*
+ * @tc.name: testNormalFeature001
+ * @tc.desc: single thread test of the SafeMap compatible operations
+ */
+HWTEST_F(UtilsSnapshotMap, testNormalFeature001, TestSize.Level0)
+{
+    SnapshotMap<string, int> demoData;
+    ASSERT_TRUE(demoData.IsEmpty());
+
+    ASSERT_TRUE(demoData.Insert("A", 1));
+    ASSERT_FALSE(demoData.Insert("A", 2));
+    demoData.EnsureInsert("B", 2);
+    demoData.EnsureInsert("B", 3);
+    ASSERT_EQ(demoData.Size(), 2);
+
+    int value = -1;
+    ASSERT_TRUE(demoData.Find("B", value));
+    ASSERT_EQ(value, 3);
+    ASSERT_FALSE(demoData.Find("C", value));
+
+    int oldValue = -1;
+    ASSERT_TRUE(demoData.FindOldAndSetNew("A", oldValue, 10));
+    ASSERT_EQ(oldValue, 1);
+    ASSERT_FALSE(demoData.FindOldAndSetNew("C", oldValue, 10));
+
+    string keys;
+    demoData.Iterate([&keys](const string& key, const int& value) { keys += key; });
+    ASSERT_EQ(keys, "AB");
+
+    demoData.Erase("A");
+    ASSERT_EQ(demoData.Size(), 1);
+    demoData.Clear();
+    ASSERT_TRUE(demoData.IsEmpty());
+}
+
+/*
+ * @tc.name: testSnapshotIsolation001
+ * @tc.desc: a snapshot keeps its content while writers publish new versions, Modify publishes changes at once
+ */
+HWTEST_F(UtilsSnapshotMap, testSnapshotIsolation001, TestSize.Level0)
+{
+    SnapshotMap<int, int> demoData;
+    demoData.Insert(1, 1);
+    auto snapshot = demoData.GetSnapshot();
+
+    demoData.Modify([](std::map<int, int>& map) {
+        map[1] = 100;
+        map[2] = 200;
+    });
+    demoData.Erase(1);
+
+    ASSERT_EQ(snapshot->size(), 1u);
+    ASSERT_EQ(snapshot->at(1), 1);
+    ASSERT_EQ(demoData.Size(), 1);
+    int value = -1;
+    ASSERT_TRUE(demoData.Find(2, value));
+    ASSERT_EQ(value, 200);
+}
+
+/*
+ * @tc.name: testConcurrentReadAndWrite001
+ * @tc.desc: readers always see a consistent version while a writer keeps publishing
+ */
+HWTEST_F(UtilsSnapshotMap, testConcurrentReadAndWrite001, TestSize.Level0)
+{
+    const int readerNum = 4;
+    const int versionNum = 500;
+    SnapshotMap<int, int> demoData;
+    demoData.Modify([](std::map<int, int>& map) {
+        map[0] = 0;
+        map[1] = 0;
+    });
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < readerNum; i++) {
+        readers.emplace_back([&demoData, &stop] {
+            while (!stop) {
+                // both keys are always changed by the same Modify
+                auto snapshot = demoData.GetSnapshot();
+                ASSERT_EQ(snapshot->at(0), snapshot->at(1));
+            }
+        });
+    }
+    for (int version = 1; version <= versionNum; version++) {
+        demoData.Modify([version](std::map<int, int>& map) {
+            map[0] = version;
+            map[1] = version;
+        });
+    }
+    stop = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    int value = -1;
+    ASSERT_TRUE(demoData.Find(1, value));
+    ASSERT_EQ(value, versionNum);
+}
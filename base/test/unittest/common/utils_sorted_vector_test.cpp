@@ -14,8 +14,11 @@
  */
 #include "sorted_vector.h"
 
+#include <algorithm>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <string>
+#include <vector>
 
 using namespace testing::ext;
 using namespace OHOS;
@@ -595,3 +598,141 @@ HWTEST_F(UtilsSortedVector, testAddNotAllowDuplicate, TestSize.Level0)
         ASSERT_EQ(i, svec[i]);
     }
 }
+
+HWTEST_F(UtilsSortedVector, testSearchMatchesStdAlgorithms, TestSize.Level0)
+{
+    SortedVector<int> svec;
+    std::vector<int> vec;
+    // 3 copies of every even number below 2000, large enough to take the prefetching path
+    for (int i = 0; i < 2000; i += 2) {
+        for (int j = 0; j < 3; j++) {
+            vec.push_back(i);
+        }
+    }
+    svec.Merge(vec);
+
+    for (int i = -1; i <= 2001; i++) {
+        auto lower = std::lower_bound(vec.begin(), vec.end(), i);
+        auto upper = std::upper_bound(vec.begin(), vec.end(), i);
+        ssize_t expected = (lower != vec.end() && *lower == i) ? (lower - vec.begin()) : -1;
+        ASSERT_EQ(svec.IndexOf(i), expected);
+        ASSERT_EQ(svec.OrderOf(i), static_cast<size_t>(upper - vec.begin()));
+    }
+}
+
+struct Session {
+    int id;
+    std::string name;
+};
+
+bool operator<(const Session& lhs, const Session& rhs)
+{
+    return lhs.id < rhs.id;
+}
+
+bool operator==(const Session& lhs, const Session& rhs)
+{
+    return lhs.id == rhs.id;
+}
+
+bool operator<(const Session& lhs, int id)
+{
+    return lhs.id < id;
+}
+
+bool operator<(int id, const Session& rhs)
+{
+    return id < rhs.id;
+}
+
+bool operator==(const Session& lhs, int id)
+{
+    return lhs.id == id;
+}
+
+HWTEST_F(UtilsSortedVector, testHeterogeneousLookup, TestSize.Level0)
+{
+    SortedVector<Session, false> svec;
+    for (int i = 9; i >= 0; i--) {
+        svec.Add(Session { i * 10, "session" + std::to_string(i) });
+    }
+    ASSERT_EQ(svec.Add(Session { 30, "again" }), static_cast<ssize_t>(-1));
+
+    // search by id without building a Session
+    ASSERT_EQ(svec.IndexOf(30), static_cast<ssize_t>(3));
+    ASSERT_EQ(svec[svec.IndexOf(30)].name, "session3");
+    ASSERT_EQ(svec.IndexOf(35), static_cast<ssize_t>(-1));
+    ASSERT_EQ(svec.OrderOf(35), static_cast<size_t>(4));
+    ASSERT_EQ(svec.OrderOf(-1), static_cast<size_t>(0));
+    ASSERT_EQ(svec.OrderOf(90), static_cast<size_t>(10));
+}
+
+HWTEST_F(UtilsSortedVector, testFromUnsorted, TestSize.Level0)
+{
+    std::vector<int> vec = { 5, 3, 9, 3, 1, 5 };
+    SortedVector<int> svec = SortedVector<int>::FromUnsorted(std::move(vec));
+    std::vector<int> expected = { 1, 3, 3, 5, 5, 9 };
+    ASSERT_TRUE(std::equal(svec.Begin(), svec.End(), expected.begin(), expected.end()));
+
+    std::vector<int> vec2 = { 5, 3, 9, 3, 1, 5 };
+    SortedVector<int, false> svec2 = SortedVector<int, false>::FromUnsorted(std::move(vec2));
+    std::vector<int> expected2 = { 1, 3, 5, 9 };
+    ASSERT_TRUE(std::equal(svec2.Begin(), svec2.End(), expected2.begin(), expected2.end()));
+}
+
+HWTEST_F(UtilsSortedVector, testMergeInPlace, TestSize.Level0)
+{
+    SortedVector<int, false> svec;
+    for (int i = 0; i < 20; i += 2) {
+        svec.Add(i);
+    }
+    svec.SetCapcity(svec.Size());
+
+    // odd numbers and duplicates of the even ones
+    std::vector<int> vec;
+    for (int i = 19; i >= 0; i--) {
+        vec.push_back(i);
+    }
+    ASSERT_EQ(svec.Merge(std::move(vec)), static_cast<size_t>(20));
+    ASSERT_TRUE(vec.empty());
+    for (ssize_t i = 0; i < 20; i++) {
+        ASSERT_EQ(i, svec[i]);
+    }
+
+    // merging with itself keeps one of each without duplicates
+    ASSERT_EQ(svec.Merge(svec), static_cast<size_t>(20));
+}
+
+HWTEST_F(UtilsSortedVector, testMergeGrowsGeometrically, TestSize.Level0)
+{
+    SortedVector<int> svec;
+    int reallocations = 0;
+    size_t capacity = svec.Capacity();
+    for (int i = 0; i < 1000; i++) {
+        int items[] = { 1000 - i, i };
+        svec.AddRange(std::begin(items), std::end(items));
+        if (svec.Capacity() != capacity) {
+            capacity = svec.Capacity();
+            reallocations++;
+        }
+    }
+    ASSERT_EQ(svec.Size(), static_cast<size_t>(2000));
+    ASSERT_TRUE(std::is_sorted(svec.Begin(), svec.End()));
+    ASSERT_LE(reallocations, 20); // 20: log2 of 2000 plus a margin, not one per merge
+}
+
+HWTEST_F(UtilsSortedVector, testAddRange, TestSize.Level0)
+{
+    SortedVector<int> svec;
+    svec.Add(4);
+    svec.Add(1);
+
+    int items[] = { 3, 0, 4, 2 };
+    ASSERT_EQ(svec.AddRange(std::begin(items), std::end(items)), static_cast<size_t>(6));
+    std::vector<int> expected = { 0, 1, 2, 3, 4, 4 };
+    ASSERT_TRUE(std::equal(svec.Begin(), svec.End(), expected.begin(), expected.end()));
+
+    SortedVector<int, false> svec2;
+    svec2.Add(4);
+    ASSERT_EQ(svec2.AddRange(std::begin(items), std::end(items)), static_cast<size_t>(4));
+}
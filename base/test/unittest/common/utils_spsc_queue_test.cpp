@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include "spsc_queue.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing::ext;
+using namespace OHOS;
+using namespace std;
+
+class UtilsSpscQueueTest : public testing::Test {
+};
+
+HWTEST_F(UtilsSpscQueueTest, testSingle001, TestSize.Level0)
+{
+    SpscQueue<string> queue(3);
+    EXPECT_EQ(queue.Capacity(), 4u);
+    EXPECT_TRUE(queue.IsEmpty());
+
+    string out;
+    EXPECT_FALSE(queue.PopNotWait(out));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.PushNoWait(to_string(i)));
+    }
+    EXPECT_TRUE(queue.IsFull());
+    EXPECT_FALSE(queue.PushNoWait(string("4")));
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.PopNotWait(out));
+        EXPECT_EQ(out, to_string(i));
+    }
+    EXPECT_TRUE(queue.IsEmpty());
+}
+
+HWTEST_F(UtilsSpscQueueTest, testBatch001, TestSize.Level0)
+{
+    SpscQueue<int> queue(8);
+    int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int out[10] = {0};
+
+    // only the room left is taken
+    EXPECT_EQ(queue.PushBatch(in, 10), 8u);
+    EXPECT_EQ(queue.PushBatch(in, 1), 0u);
+    EXPECT_EQ(queue.PopBatch(out, 3), 3u);
+    EXPECT_EQ(out[2], 2);
+    EXPECT_EQ(queue.PushBatch(in + 8, 2), 2u);
+    EXPECT_EQ(queue.PopBatch(out, 10), 7u);
+    for (int i = 0; i < 7; ++i) {
+        EXPECT_EQ(out[i], i + 3);
+    }
+    EXPECT_EQ(queue.PopBatch(out, 10), 0u);
+}
+
+HWTEST_F(UtilsSpscQueueTest, testConcurrent001, TestSize.Level0)
+{
+    const int elemNum = 100000;
+    SpscQueue<int> queue(64);
+    thread producer([&queue] {
+        int batch[16];
+        int next = 0;
+        while (next < elemNum) {
+            int count = 0;
+            for (; (count < 16) && (next + count < elemNum); ++count) {
+                batch[count] = next + count;
+            }
+            next += queue.PushBatch(batch, count);
+            this_thread::yield();
+        }
+    });
+
+    bool ordered = true;
+    int expected = 0;
+    int batch[16];
+    while (expected < elemNum) {
+        size_t popped = queue.PopBatch(batch, 16);
+        for (size_t i = 0; i < popped; ++i) {
+            ordered = ordered && (batch[i] == expected++);
+        }
+        this_thread::yield();
+    }
+    producer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.IsEmpty());
+}
+
+HWTEST_F(UtilsSpscQueueTest, testDestroy001, TestSize.Level0)
+{
+    auto elem = make_shared<int>(0);
+    {
+        SpscQueue<shared_ptr<int>> queue(4);
+        queue.PushNoWait(elem);
+        queue.PushNoWait(elem);
+        EXPECT_EQ(elem.use_count(), 3);
+    }
+    EXPECT_EQ(elem.use_count(), 1);
+}
@@ -14,8 +14,13 @@
  */
 #include <gtest/gtest.h>
 #include "thread_pool.h"
+#include "thread_ex.h"
+#include "errors.h"
+#include <atomic>
 #include <chrono>
 #include <cstdio>
+#include <sched.h>
+#include <sys/prctl.h>
 
 using namespace testing::ext;
 using namespace OHOS;
@@ -269,3 +274,175 @@ HWTEST_F(UtilsThreadPoolTest, test_08, TestSize.Level0)
     pool.Stop();
 }
 
+
+HWTEST_F(UtilsThreadPoolTest, test_09, TestSize.Level0)
+{
+    ThreadPool pool("test_09_pool");
+    EXPECT_EQ(pool.SetCpuAffinity({-1}), (uint32_t)ERR_INVALID_VALUE);
+    EXPECT_EQ(pool.SetCpuAffinity({0}, true), (uint32_t)ERR_OK);
+    pool.Start(2);
+    EXPECT_EQ(pool.SetCpuAffinity({0}), (uint32_t)ERR_INVALID_OPERATION);
+    EXPECT_EQ(pool.SetNumaAware(true), (uint32_t)ERR_INVALID_OPERATION);
+
+    // every worker is bound to cpu 0 and named after the pool
+    std::atomic<int> onCpu0(0);
+    std::atomic<int> named(0);
+    for (int i = 0; i < 10; ++i) {
+        pool.AddTask([&onCpu0, &named] {
+            if (sched_getcpu() == 0) {
+                ++onCpu0;
+            }
+            char name[MAX_THREAD_NAME_LEN + 1] = {0};
+            prctl(PR_GET_NAME, name, 0, 0, 0);
+            if (std::string(name).find("test_09_pool") == 0) {
+                ++named;
+            }
+        });
+    }
+
+    sleep(1);
+    EXPECT_EQ(onCpu0, 10);
+    EXPECT_EQ(named, 10);
+    pool.Stop();
+}
+
+HWTEST_F(UtilsThreadPoolTest, test_10, TestSize.Level0)
+{
+    ThreadPool pool;
+    EXPECT_EQ(pool.SetNumaAware(true), (uint32_t)ERR_OK);
+    pool.Start(4);
+    EXPECT_EQ((int)pool.GetThreadsNum(), 4);
+    // one queue per NUMA node, at most one per worker
+    EXPECT_GE((int)pool.GetQueuesNum(), 1);
+    EXPECT_LE((int)pool.GetQueuesNum(), 4);
+    pool.SetMaxTaskNum(10);
+
+    for (int i = 0; i < 8; ++i) {
+        auto task = std::bind(TestFuncAddOneTime, i);
+        pool.AddTask(task);
+    }
+
+    for (int i = 0; i < 7; ++i) {
+        auto task = std::bind(TestFuncSubOneTime, i);
+        pool.AddTask(task);
+    }
+
+    sleep(1);
+    EXPECT_EQ((int)pool.GetCurTaskNum(), 0);
+    EXPECT_EQ(g_times, 1);
+    pool.Stop();
+}
+
+HWTEST_F(UtilsThreadPoolTest, test_11, TestSize.Level0)
+{
+    ThreadPool pool;
+    pool.Start(2);
+    pool.SetMaxTaskNum(1);
+    EXPECT_EQ(pool.GetAddedTaskNum(), 0u);
+    EXPECT_EQ((int)pool.GetPendingTaskNum(), 0);
+
+    // two workers wait for g_ready, one task stays in the queue and the last add blocks
+    for (int i = 0; i < 3; ++i) {
+        auto task = std::bind(TestFuncAddWait, i);
+        pool.AddTask(task);
+    }
+    std::thread producer([&pool] {
+        auto task = std::bind(TestFuncAddWait, 3);
+        pool.AddTask(task);
+    });
+
+    sleep(1);
+    EXPECT_EQ((int)pool.GetPendingTaskNum(), 1);
+    EXPECT_GE(pool.GetBlockedAddNum(), 1u);
+    EXPECT_EQ(pool.GetFinishedTaskNum(), 0u);
+    {
+        std::lock_guard<std::mutex> lk(g_mutex);
+        g_ready = true;
+    }
+    g_cv.notify_all();
+    producer.join();
+
+    sleep(1);
+    EXPECT_EQ(pool.GetAddedTaskNum(), 4u);
+    EXPECT_EQ(pool.GetFinishedTaskNum(), 4u);
+    EXPECT_EQ((int)pool.GetPendingTaskNum(), 0);
+    EXPECT_EQ(pool.GetQueueWaitHistogram().GetCount(), 4u);
+    EXPECT_EQ(pool.GetRunTimeHistogram().GetCount(), 4u);
+    // the first two tasks ran for about one second
+    EXPECT_GE(pool.GetRunTimeHistogram().GetMax(), 500000u);
+    EXPECT_GT(pool.GetWorkerBusyRatio(0) + pool.GetWorkerBusyRatio(1), 0.5);
+    EXPECT_EQ(pool.GetWorkerBusyRatio(2), 0);
+
+    pool.ResetMetrics();
+    EXPECT_EQ(pool.GetFinishedTaskNum(), 0u);
+    EXPECT_EQ(pool.GetRunTimeHistogram().GetCount(), 0u);
+    pool.Stop();
+}
+
+// keep the only worker busy until g_ready, the queue holds one more task
+static void FillSingleWorkerPool(ThreadPool& pool)
+{
+    pool.Start(1);
+    pool.SetMaxTaskNum(1);
+    pool.AddTask(std::bind(TestFuncAddWait, 0));
+    sleep(1);
+    pool.AddTask(std::bind(TestFuncAddWait, 1));
+    EXPECT_EQ((int)pool.GetCurTaskNum(), 1);
+}
+
+static void ReleaseSingleWorkerPool(ThreadPool& pool)
+{
+    {
+        std::lock_guard<std::mutex> lk(g_mutex);
+        g_ready = true;
+    }
+    g_cv.notify_all();
+    sleep(1);
+    pool.Stop();
+}
+
+HWTEST_F(UtilsThreadPoolTest, test_12, TestSize.Level0)
+{
+    ThreadPool pool;
+    EXPECT_EQ(pool.GetOverloadPolicy(), ThreadPool::OverloadPolicy::BLOCK);
+    FillSingleWorkerPool(pool);
+
+    // BLOCK: TryAddTask and a timed AddTask give up
+    EXPECT_EQ(pool.TryAddTask(std::bind(TestFuncAddWait, 2)), (uint32_t)ERR_WOULD_BLOCK);
+    auto begin = std::chrono::steady_clock::now();
+    EXPECT_EQ(pool.AddTask(std::bind(TestFuncAddWait, 3), 100), (uint32_t)ERR_TIMED_OUT);
+    EXPECT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(100));
+    EXPECT_EQ(pool.GetRejectedTaskNum(), 2u);
+
+    // REJECT: AddTask does not wait either
+    pool.SetOverloadPolicy(ThreadPool::OverloadPolicy::REJECT);
+    pool.AddTask(std::bind(TestFuncAddWait, 4));
+    EXPECT_EQ(pool.GetRejectedTaskNum(), 3u);
+    EXPECT_EQ((int)pool.GetCurTaskNum(), 1);
+
+    ReleaseSingleWorkerPool(pool);
+    EXPECT_EQ(g_times, 2);
+}
+
+HWTEST_F(UtilsThreadPoolTest, test_13, TestSize.Level0)
+{
+    ThreadPool pool;
+    FillSingleWorkerPool(pool);
+
+    // CALLER_RUNS: the task runs in this thread
+    pool.SetOverloadPolicy(ThreadPool::OverloadPolicy::CALLER_RUNS);
+    std::thread::id runner;
+    EXPECT_EQ(pool.TryAddTask([&runner] { runner = std::this_thread::get_id(); }), (uint32_t)ERR_OK);
+    EXPECT_EQ(runner, std::this_thread::get_id());
+
+    // DROP_OLDEST: the queued task is replaced
+    pool.SetOverloadPolicy(ThreadPool::OverloadPolicy::DROP_OLDEST);
+    pool.AddTask(std::bind(TestFuncSubOneTime, 2));
+    EXPECT_EQ(pool.GetDroppedTaskNum(), 1u);
+    EXPECT_EQ((int)pool.GetCurTaskNum(), 1);
+
+    ReleaseSingleWorkerPool(pool);
+    // first task added one, the dropped one never ran, the last one subtracted one
+    EXPECT_EQ(g_times, 0);
+    EXPECT_EQ(pool.GetRejectedTaskNum(), 0u);
+}
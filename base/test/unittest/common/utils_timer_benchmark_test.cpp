@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "timer.h"
+#include "common_timer_errors.h"
+#include "latency_histogram.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace testing::ext;
+using namespace OHOS;
+using namespace std;
+
+namespace {
+const int TIMER_NUM = 2000;
+const int RUN_MS = 2000;
+
+void Report(const string& name, const Utils::Timer& timer)
+{
+    const LatencyHistogram& lateness = timer.GetLatenessHistogram();
+    const LatencyHistogram& callbackTime = timer.GetCallbackTimeHistogram();
+    cout << name << ": " << lateness.GetCount() << " expirations, lateness us"
+         << " p50 " << lateness.GetPercentile(50)     // 50: median
+         << " p90 " << lateness.GetPercentile(90)     // 90: percentile
+         << " p99 " << lateness.GetPercentile(99)     // 99: percentile
+         << " p99.9 " << lateness.GetPercentile(99.9) // 99.9: percentile
+         << " max " << lateness.GetMax()
+         << ", callback us p99 " << callbackTime.GetPercentile(99) // 99: percentile
+         << ", overruns " << timer.GetOverrunCount() << endl;
+}
+}
+
+class UtilsTimerBenchmarkTest : public testing::Test {
+};
+
+/*
+ * @tc.name: benchmarkTimerJitter001
+ * @tc.desc: thousands of periodic timers of spread intervals in each mode, report the lateness percentiles
+ */
+HWTEST_F(UtilsTimerBenchmarkTest, benchmarkTimerJitter001, TestSize.Level3)
+{
+    const Utils::Timer::Mode modes[] = {Utils::Timer::Mode::TIMERFD_PER_INTERVAL, Utils::Timer::Mode::TIMING_WHEEL};
+    const string names[] = {"timerfd per interval", "timing wheel"};
+    for (int m = 0; m < 2; m++) { // 2: modes
+        atomic<uint64_t> fired(0);
+        Utils::Timer timer("bench_timer", 1000, modes[m]);
+        EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+        for (int i = 0; i < TIMER_NUM; i++) {
+            timer.Register([&fired] { fired++; }, 10 + i % 40); // 10, 40: intervals in [10, 50)ms
+        }
+        this_thread::sleep_for(chrono::milliseconds(RUN_MS));
+        timer.Shutdown();
+        Report(names[m], timer);
+        EXPECT_GT(fired.load(), 0u);
+    }
+}
+
+/*
+ * @tc.name: benchmarkTimerJitter002
+ * @tc.desc: thousands of microsecond timers, exact and with slack, report the lateness percentiles
+ */
+HWTEST_F(UtilsTimerBenchmarkTest, benchmarkTimerJitter002, TestSize.Level3)
+{
+    const uint64_t slacks[] = {0, 1000}; // 1000: 1ms slack
+    for (uint64_t slackUs : slacks) {
+        atomic<uint64_t> fired(0);
+        Utils::Timer timer("bench_timer");
+        timer.SetSlack(slackUs);
+        EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+        for (int i = 0; i < TIMER_NUM; i++) {
+            timer.RegisterUs([&fired] { fired++; }, 10000 + i * 17); // 10000, 17: spread over [10, 44)ms
+        }
+        this_thread::sleep_for(chrono::milliseconds(RUN_MS));
+        timer.Shutdown();
+        Report("high resolution, slack " + to_string(slackUs) + "us", timer);
+        EXPECT_GT(fired.load(), 0u);
+    }
+}
@@ -16,9 +16,14 @@
 #include <gtest/gtest.h>
 #include "timer.h"
 #include "common_timer_errors.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <mutex>
+#include <set>
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <vector>
 #include <stdatomic.h>
 #include <sys/time.h>
 
@@ -337,3 +342,580 @@ HWTEST_F(UtilsTimerTest, testTimer011, TestSize.Level0)
     EXPECT_GE(g_data1, 8); /* 12 for max */
 }
 
+
+/*
+ * @tc.name: testTimingWheel001
+ * @tc.desc: timing wheel expires nodes at their tick on every level, in order, and skips idle ticks
+ */
+HWTEST_F(UtilsTimerTest, testTimingWheel001, TestSize.Level0)
+{
+    const uint64_t start = 1000;
+    Utils::TimingWheel wheel(start);
+    // delays on level 0, on each upper level, and beyond the reach of the wheel
+    std::vector<uint64_t> delays = { 0, 1, 255, 256, 300, 16383, 16384, 1048576, 70000000, 5000000000 };
+    std::vector<Utils::WheelNode> nodes(delays.size());
+    for (size_t i = 0; i < delays.size(); i++) {
+        wheel.Add(&nodes[i], start + delays[i]);
+    }
+    EXPECT_EQ(wheel.Size(), delays.size());
+    EXPECT_EQ(wheel.NextExpire(), start);
+
+    std::vector<Utils::WheelNode*> expired;
+    for (size_t i = 0; i < delays.size(); i++) {
+        uint64_t expire = start + delays[i];
+        wheel.Advance(expire - 1, expired);
+        EXPECT_TRUE(expired.empty()) << "delay " << delays[i];
+        wheel.Advance(expire, expired);
+        ASSERT_EQ(expired.size(), 1u) << "delay " << delays[i];
+        EXPECT_EQ(expired[0], &nodes[i]);
+        expired.clear();
+    }
+    EXPECT_TRUE(wheel.IsEmpty());
+    EXPECT_EQ(wheel.NextExpire(), Utils::TimingWheel::NO_EXPIRE);
+}
+
+/*
+ * @tc.name: testTimingWheel002
+ * @tc.desc: removed nodes never expire, a late Advance returns all due nodes at once
+ */
+HWTEST_F(UtilsTimerTest, testTimingWheel002, TestSize.Level0)
+{
+    Utils::TimingWheel wheel(0);
+    const size_t nodeNum = 1000;
+    std::vector<Utils::WheelNode> nodes(nodeNum);
+    for (size_t i = 0; i < nodeNum; i++) {
+        wheel.Add(&nodes[i], i * 37); // 37: spread over several levels
+    }
+    for (size_t i = 0; i < nodeNum; i += 2) {
+        wheel.Remove(&nodes[i]);
+    }
+    EXPECT_EQ(wheel.Size(), nodeNum / 2);
+
+    std::vector<Utils::WheelNode*> expired;
+    wheel.Advance(nodeNum * 37, expired);
+    ASSERT_EQ(expired.size(), nodeNum / 2);
+    for (size_t i = 0; i < expired.size(); i++) {
+        EXPECT_EQ(expired[i], &nodes[i * 2 + 1]);
+        EXPECT_FALSE(expired[i]->IsLinked());
+    }
+    EXPECT_TRUE(wheel.IsEmpty());
+}
+
+/*
+ * @tc.name: testTimerWheelMode001
+ * @tc.desc: once and periodic timers in timing wheel mode
+ */
+HWTEST_F(UtilsTimerTest, testTimerWheelMode001, TestSize.Level0)
+{
+    g_data1 = 0;
+    g_data2 = 0;
+    Utils::Timer timer("test_timer", 1000, Utils::Timer::Mode::TIMING_WHEEL);
+    uint32_t ret = timer.Setup();
+    EXPECT_EQ(Utils::TIMER_ERR_OK, ret);
+    timer.Register(TimeOutCallback1, 10, true);
+    timer.Register(TimeOutCallback1, 10, true);
+    uint32_t periodicId = timer.Register(TimeOutCallback2, 10);
+    uint32_t canceledId = timer.Register(TimeOutCallback1, 30, true);
+    timer.Unregister(canceledId);
+    std::this_thread::sleep_for(std::chrono::milliseconds(105));
+    timer.Unregister(periodicId);
+    int periodicCount = g_data2;
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    timer.Shutdown();
+    EXPECT_EQ(2, g_data1);
+    EXPECT_GE(periodicCount, 5);
+    EXPECT_EQ(periodicCount, g_data2);
+}
+
+/*
+ * @tc.name: testTimerWheelMode002
+ * @tc.desc: many once timers share one timerfd in timing wheel mode, each one fires not before its time
+ */
+HWTEST_F(UtilsTimerTest, testTimerWheelMode002, TestSize.Level0)
+{
+    const int timerNum = 10000;
+    std::atomic<int> fired(0);
+    std::atomic<int> early(0);
+    Utils::Timer timer("test_timer", 1000, Utils::Timer::Mode::TIMING_WHEEL);
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < timerNum; i++) {
+        uint32_t interval = 200 + i % 50; // 200, 50: intervals in [200, 250)ms, longer than registering them all
+        auto begin = std::chrono::steady_clock::now();
+        ids.push_back(timer.Register([&fired, &early, begin, interval] {
+            if (std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(interval)) {
+                early++;
+            }
+            fired++;
+        }, interval, true));
+    }
+    for (int i = 0; i < timerNum; i += 2) {
+        timer.Unregister(ids[i]);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    timer.Shutdown();
+    EXPECT_EQ(0, early.load());
+    EXPECT_EQ(timerNum / 2, fired.load()); // 2: every other timer was unregistered
+}
+
+/*
+ * @tc.name: testTimerExecutor001
+ * @tc.desc: callbacks dispatched to a ThreadPool, a slow periodic callback neither delays another timer
+ *           nor runs concurrently with itself
+ */
+HWTEST_F(UtilsTimerTest, testTimerExecutor001, TestSize.Level0)
+{
+    ThreadPool pool("timer_executor");
+    pool.Start(2); // 2: the slow callback can not take all the workers
+    std::atomic<int> inFlight(0);
+    std::atomic<int> overlapped(0);
+    std::atomic<int> slowRuns(0);
+    std::atomic<int64_t> onceDelay(-1);
+    Utils::Timer timer("test_timer");
+    timer.SetExecutor(&pool);
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+
+    timer.Register([&inFlight, &overlapped, &slowRuns] {
+        if (inFlight.fetch_add(1) != 0) {
+            overlapped++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // 50: five periods of the timer
+        slowRuns++;
+        inFlight--;
+    }, 10);
+    int64_t begin = CurMs();
+    timer.Register([&onceDelay, begin] { onceDelay = CurMs() - begin; }, 30, true);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    timer.Shutdown();
+    pool.Stop();
+    EXPECT_EQ(0, overlapped.load());
+    EXPECT_GE(slowRuns.load(), 2);
+    EXPECT_LE(slowRuns.load(), 7); // 7: expirations while running are merged, at most one run per 50ms
+    EXPECT_GE(onceDelay.load(), 30);
+    EXPECT_LT(onceDelay.load(), 50); // 50: one slow callback would have taken this long inline
+}
+
+/*
+ * @tc.name: testTimerExecutor002
+ * @tc.desc: a custom executor in timing wheel mode, queued callbacks of an unregistered timer are skipped
+ */
+HWTEST_F(UtilsTimerTest, testTimerExecutor002, TestSize.Level0)
+{
+    std::mutex tasksMutex;
+    std::vector<Utils::Timer::TimerCallback> tasks;
+    std::atomic<int> fired(0);
+    Utils::Timer timer("test_timer", 1000, Utils::Timer::Mode::TIMING_WHEEL);
+    timer.SetExecutor([&tasksMutex, &tasks](const Utils::Timer::TimerCallback& task) {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        tasks.push_back(task);
+    });
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+
+    uint32_t keep = timer.Register([&fired] { fired++; }, 10);
+    uint32_t drop = timer.Register([&fired] { fired += 100; }, 10); // 100: tells the two timers apart
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    timer.Unregister(drop);
+
+    std::vector<Utils::Timer::TimerCallback> queued;
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        queued.swap(tasks);
+    }
+    // each timer was handed over once, the later expirations wait for that run
+    EXPECT_EQ(2u, queued.size());
+    for (auto& task : queued) {
+        task();
+    }
+    // the expirations meanwhile were merged into one more run, the unregistered timer ran neither
+    EXPECT_EQ(2, fired.load()); // 2: the run handed over and the merged one
+    timer.Unregister(keep);
+    timer.Shutdown();
+}
+
+/*
+ * @tc.name: testTimerExecutor003
+ * @tc.desc: expirations rejected by a full ThreadPool are lost, the timer keeps firing once the pool has room
+ */
+HWTEST_F(UtilsTimerTest, testTimerExecutor003, TestSize.Level0)
+{
+    ThreadPool pool;
+    pool.SetMaxTaskNum(1);
+    pool.SetOverloadPolicy(ThreadPool::OverloadPolicy::REJECT);
+    pool.Start(1);
+    std::atomic<bool> release(false);
+    pool.AddTask([&release] {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    while (pool.GetCurTaskNum() != 0) {
+        std::this_thread::yield();
+    }
+    pool.AddTask([] {});
+
+    std::atomic<int> fired(0);
+    Utils::Timer timer("test_timer");
+    timer.SetExecutor(&pool);
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+    timer.Register([&fired] { fired++; }, 10);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(0, fired.load());
+    EXPECT_GT(pool.GetRejectedTaskNum(), 0u);
+
+    release = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    timer.Shutdown();
+    EXPECT_GT(fired.load(), 0);
+    pool.Stop();
+}
+
+/*
+ * @tc.name: testTimerExecutor004
+ * @tc.desc: a full ThreadPool with OverloadPolicy::BLOCK never holds the timer thread up, expirations are dropped
+ */
+HWTEST_F(UtilsTimerTest, testTimerExecutor004, TestSize.Level0)
+{
+    ThreadPool pool;
+    pool.SetMaxTaskNum(1);
+    pool.SetOverloadPolicy(ThreadPool::OverloadPolicy::BLOCK);
+    pool.Start(1);
+    std::atomic<bool> release(false);
+    pool.AddTask([&release] {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    while (pool.GetCurTaskNum() != 0) {
+        std::this_thread::yield();
+    }
+    pool.AddTask([] {});
+
+    std::atomic<int> fired(0);
+    Utils::Timer timer("test_timer");
+    timer.SetExecutor(&pool);
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+    timer.Register([&fired] { fired++; }, 10);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(0, fired.load());
+    EXPECT_GT(timer.GetDroppedCount(), 1u);
+
+    release = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    timer.Shutdown();
+    EXPECT_GT(fired.load(), 0);
+    pool.Stop();
+}
+
+/*
+ * @tc.name: testTimerRestart001
+ * @tc.desc: Setup again after Shutdown runs new timers, a second Setup while running is refused
+ */
+HWTEST_F(UtilsTimerTest, testTimerRestart001, TestSize.Level0)
+{
+    const Utils::Timer::Mode modes[] = {Utils::Timer::Mode::TIMERFD_PER_INTERVAL, Utils::Timer::Mode::TIMING_WHEEL};
+    for (auto mode : modes) {
+        std::atomic<int> periodic(0);
+        std::atomic<int> once(0);
+        Utils::Timer timer("test_timer", 1000, mode);
+        EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+        EXPECT_EQ(Utils::TIMER_ERR_INVALID_VALUE, timer.Setup());
+        timer.Register([&periodic] { periodic++; }, 10);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        timer.Shutdown();
+        EXPECT_GT(periodic.load(), 0);
+
+        EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+        timer.Register([&once] { once++; }, 10, true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        timer.Shutdown();
+        EXPECT_EQ(1, once.load());
+    }
+}
+
+/*
+ * @tc.name: testTimerUnregisterInCallback001
+ * @tc.desc: a callback unregisters timers sharing its timerfd and registers a new one during the same expiration
+ */
+HWTEST_F(UtilsTimerTest, testTimerUnregisterInCallback001, TestSize.Level0)
+{
+    const int timerNum = 5;
+    const uint32_t interval = 50;
+    std::atomic<int> counts[timerNum + 1] = {};
+    uint32_t ids[timerNum] = {};
+    Utils::Timer timer("test_timer");
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+
+    ids[0] = timer.Register([&timer, &counts, &ids, interval] {
+        counts[0]++;
+        timer.Unregister(ids[0]);
+        timer.Unregister(ids[1]); // 1: the next one in the list
+        timer.Register([&counts] { counts[timerNum]++; }, interval);
+    }, interval);
+    for (int i = 1; i < timerNum; i++) {
+        ids[i] = timer.Register([&counts, i] { counts[i]++; }, interval);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(interval + interval / 2)); // 2: half way to the next one
+    timer.Shutdown();
+    EXPECT_EQ(1, counts[0].load());
+    EXPECT_EQ(0, counts[1].load());
+    for (int i = 2; i < timerNum; i++) { // 2: the ones after the unregistered
+        EXPECT_EQ(1, counts[i].load());
+    }
+    EXPECT_EQ(0, counts[timerNum].load());
+}
+
+/*
+ * @tc.name: testTimerUnregisterInCallback002
+ * @tc.desc: in TIMING_WHEEL mode two timers due in the same tick unregister each other, only the first one runs
+ */
+HWTEST_F(UtilsTimerTest, testTimerUnregisterInCallback002, TestSize.Level0)
+{
+    std::atomic<int> runs(0);
+    std::vector<uint32_t> timerIds;
+    Utils::Timer timer("test_timer", 1000, Utils::Timer::Mode::TIMING_WHEEL);
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+    // one batch shares the start tick, both are due in the same tick
+    std::vector<Utils::Timer::TimerRequest> requests;
+    requests.push_back({[&timer, &timerIds, &runs] { runs++; timer.Unregister(timerIds[1]); }, 20, true});
+    requests.push_back({[&timer, &timerIds, &runs] { runs++; timer.Unregister(timerIds[0]); }, 20, true});
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.RegisterBatch(requests, timerIds));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    timer.Shutdown();
+    EXPECT_EQ(1, runs.load());
+}
+
+/*
+ * @tc.name: testTimerUnregisterMany001
+ * @tc.desc: many timers of the same and of distinct intervals unregistered in any order, none of them fires
+ */
+HWTEST_F(UtilsTimerTest, testTimerUnregisterMany001, TestSize.Level0)
+{
+    const int timerNum = 2000;
+    std::atomic<int> fired(0);
+    Utils::Timer timer("test_timer");
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < timerNum; i++) {
+        uint32_t interval = 100 + i % 4; // 100, 4: four timerfds shared by all
+        ids.push_back(timer.Register([&fired] { fired++; }, interval, false));
+    }
+    for (int i = 0; i < timerNum; i += 2) { // 2: every even one first, then the odd ones backward
+        timer.Unregister(ids[i]);
+    }
+    for (int i = timerNum - 1; i > 0; i -= 2) {
+        timer.Unregister(ids[i]);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    timer.Shutdown();
+    EXPECT_EQ(0, fired.load());
+}
+
+/*
+ * @tc.name: testTimerHighRes001
+ * @tc.desc: microsecond periodic timer and absolute deadline timer, neither fires early
+ */
+HWTEST_F(UtilsTimerTest, testTimerHighRes001, TestSize.Level0)
+{
+    std::atomic<int> ticks(0);
+    std::atomic<uint64_t> firedAt(0);
+    Utils::Timer timer("test_timer");
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+    EXPECT_EQ(Utils::TIMER_ERR_DEAL_FAILED, timer.RegisterUs([] {}, 0));
+
+    uint64_t begin = Utils::Timer::NowNs();
+    uint32_t periodic = timer.RegisterUs([&ticks] { ticks++; }, 500); // 500: 0.5ms period
+    uint64_t deadline = begin + 20 * 1000 * 1000; // 20 * 1000 * 1000: 20ms in ns
+    timer.RegisterAt([&firedAt] { firedAt = Utils::Timer::NowNs(); }, deadline);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    timer.Unregister(periodic);
+    int ticksAtUnregister = ticks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    timer.Shutdown();
+
+    EXPECT_GE(ticksAtUnregister, 50); // 50: a quarter of 100ms / 0.5ms, the rest may be merged on a busy host
+    EXPECT_LE(ticksAtUnregister, 201); // 201: never more than one per period
+    EXPECT_LE(ticks.load(), ticksAtUnregister + 1); // 1: the one that may be running while unregistering
+    EXPECT_GE(firedAt.load(), deadline);
+}
+
+/*
+ * @tc.name: testTimerHighResUnregister001
+ * @tc.desc: two high resolution timers due in the same wakeup unregister each other, only the first one runs
+ */
+HWTEST_F(UtilsTimerTest, testTimerHighResUnregister001, TestSize.Level0)
+{
+    std::atomic<int> runs(0);
+    uint32_t timerIds[2] = {0, 0};
+    Utils::Timer timer("test_timer");
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+    uint64_t deadline = Utils::Timer::NowNs() + 20 * 1000 * 1000; // 20 * 1000 * 1000: 20ms in ns
+    timerIds[0] = timer.RegisterAt([&timer, &timerIds, &runs] { runs++; timer.Unregister(timerIds[1]); }, deadline);
+    timerIds[1] = timer.RegisterAt([&timer, &timerIds, &runs] { runs++; timer.Unregister(timerIds[0]); }, deadline);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    timer.Shutdown();
+    EXPECT_EQ(1, runs.load());
+}
+
+/*
+ * @tc.name: testTimerHighResSlack001
+ * @tc.desc: deadlines within the slack window are run by one wakeup, late by no more than the slack
+ */
+HWTEST_F(UtilsTimerTest, testTimerHighResSlack001, TestSize.Level0)
+{
+    const int timerNum = 10;
+    const uint64_t slackUs = 20000;
+    const uint64_t stepNs = 500 * 1000; // 500 * 1000: deadlines 0.5ms apart, 5ms for all
+    std::mutex firedMutex;
+    std::vector<uint64_t> firedAt;
+    Utils::Timer timer("test_timer");
+    timer.SetSlack(slackUs);
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+
+    uint64_t first = Utils::Timer::NowNs() + 20 * 1000 * 1000; // 20 * 1000 * 1000: 20ms in ns
+    for (int i = 0; i < timerNum; i++) {
+        uint64_t deadline = first + i * stepNs;
+        timer.RegisterAt([&firedMutex, &firedAt, deadline] {
+            uint64_t now = Utils::Timer::NowNs();
+            EXPECT_GE(now, deadline);
+            std::lock_guard<std::mutex> lock(firedMutex);
+            firedAt.push_back(now);
+        }, deadline);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    timer.Shutdown();
+
+    ASSERT_EQ(static_cast<size_t>(timerNum), firedAt.size());
+    // run back to back by one wakeup, not spread over the 4.5ms of their deadlines
+    EXPECT_LT(firedAt.back() - firedAt.front(), stepNs);
+    EXPECT_GE(firedAt.front(), first + (timerNum - 1) * stepNs);
+}
+
+/*
+ * @tc.name: testTimerMetrics001
+ * @tc.desc: lateness, callback time and overruns of a periodic timer whose callback outlasts its period
+ */
+HWTEST_F(UtilsTimerTest, testTimerMetrics001, TestSize.Level0)
+{
+    const Utils::Timer::Mode modes[] = {Utils::Timer::Mode::TIMERFD_PER_INTERVAL, Utils::Timer::Mode::TIMING_WHEEL};
+    for (auto mode : modes) {
+        std::atomic<int> runs(0);
+        Utils::Timer timer("test_timer", 1000, mode);
+        EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+        timer.Register([&runs] {
+            runs++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(25)); // 25: two and a half periods
+        }, 10);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        timer.Shutdown();
+
+        const LatencyHistogram& lateness = timer.GetLatenessHistogram();
+        const LatencyHistogram& callbackTime = timer.GetCallbackTimeHistogram();
+        EXPECT_EQ(static_cast<uint64_t>(runs.load()), lateness.GetCount());
+        EXPECT_EQ(static_cast<uint64_t>(runs.load()), callbackTime.GetCount());
+        EXPECT_GE(callbackTime.GetPercentile(50), 16384u); // 16384: bucket bound below 25ms in us
+        EXPECT_GE(timer.GetOverrunCount(), static_cast<uint64_t>(runs.load())); // every run misses a period
+        EXPECT_GE(lateness.GetMax(), 1000u); // 1000: the callbacks delay the next expiration by ms
+
+        timer.ResetMetrics();
+        EXPECT_EQ(0u, lateness.GetCount());
+        EXPECT_EQ(0u, timer.GetOverrunCount());
+    }
+}
+
+/*
+ * @tc.name: testTimerRegisterBatch001
+ * @tc.desc: a batch of periodic and once timers in both modes, periodic ones of one interval share a timerfd
+ */
+HWTEST_F(UtilsTimerTest, testTimerRegisterBatch001, TestSize.Level0)
+{
+    const Utils::Timer::Mode modes[] = {Utils::Timer::Mode::TIMERFD_PER_INTERVAL, Utils::Timer::Mode::TIMING_WHEEL};
+    for (auto mode : modes) {
+        const int timerNum = 50;
+        std::atomic<int> onceRuns(0);
+        std::atomic<int> periodicRuns(0);
+        std::vector<Utils::Timer::TimerRequest> requests;
+        for (int i = 0; i < timerNum; i++) {
+            requests.push_back({[&onceRuns] { onceRuns++; }, 5, true}); // 5: ms
+            requests.push_back({[&periodicRuns] { periodicRuns++; }, 20, false}); // 20: ms
+        }
+        Utils::Timer timer("test_timer", 1000, mode);
+        EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+        std::vector<uint32_t> timerIds;
+        EXPECT_EQ(Utils::TIMER_ERR_OK, timer.RegisterBatch(requests, timerIds));
+        ASSERT_EQ(requests.size(), timerIds.size());
+        std::set<uint32_t> uniqueIds(timerIds.begin(), timerIds.end());
+        EXPECT_EQ(timerIds.size(), uniqueIds.size());
+        EXPECT_EQ(0u, uniqueIds.count(Utils::TIMER_ERR_DEAL_FAILED));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        for (size_t i = 1; i < timerIds.size(); i += 2) { // 2: the periodic ones
+            timer.Unregister(timerIds[i]);
+        }
+        int periodic = periodicRuns.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        timer.Shutdown();
+
+        EXPECT_EQ(timerNum, onceRuns.load());
+        EXPECT_GE(periodic, timerNum);
+        EXPECT_LE(periodicRuns.load(), periodic + timerNum); // at most the round running at Unregister
+    }
+}
+
+/*
+ * @tc.name: testTimerRegisterAsync001
+ * @tc.desc: threads register timers lock-free, before and after Setup, some are unregistered at once
+ */
+HWTEST_F(UtilsTimerTest, testTimerRegisterAsync001, TestSize.Level0)
+{
+    const Utils::Timer::Mode modes[] = {Utils::Timer::Mode::TIMERFD_PER_INTERVAL, Utils::Timer::Mode::TIMING_WHEEL};
+    for (auto mode : modes) {
+        const int threadNum = 4;
+        const int timersPerThread = 100;
+        std::atomic<int> runs(0);
+        std::atomic<int> cancelledRuns(0);
+        Utils::Timer timer("test_timer", 1000, mode);
+        timer.RegisterAsync([&runs] { runs++; }, 1, true);
+        EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadNum; i++) {
+            threads.emplace_back([&timer, &runs, &cancelledRuns] {
+                for (int j = 0; j < timersPerThread; j++) {
+                    uint32_t timerId = timer.RegisterAsync([&runs] { runs++; }, 10, true); // 10: ms
+                    EXPECT_NE(Utils::TIMER_ERR_DEAL_FAILED, timerId);
+                    timerId = timer.RegisterAsync([&cancelledRuns] { cancelledRuns++; }, 10, true); // 10: ms
+                    timer.Unregister(timerId);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        timer.Shutdown();
+
+        EXPECT_EQ(threadNum * timersPerThread + 1, runs.load());
+        EXPECT_EQ(0, cancelledRuns.load());
+    }
+}
+
+/*
+ * @tc.name: testTimerRegisterAsync002
+ * @tc.desc: a RegisterAsync unregistered before it is linked never runs, the others queued with it do
+ */
+HWTEST_F(UtilsTimerTest, testTimerRegisterAsync002, TestSize.Level0)
+{
+    std::atomic<int> runs(0);
+    std::atomic<int> cancelledRuns(0);
+    Utils::Timer timer("test_timer");
+    timer.RegisterAsync([&runs] { runs++; }, 1, true);
+    uint32_t timerId = timer.RegisterAsync([&cancelledRuns] { cancelledRuns++; }, 1, true);
+    timer.Unregister(timerId);
+    EXPECT_EQ(Utils::TIMER_ERR_OK, timer.Setup());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    timer.Shutdown();
+    EXPECT_EQ(1, runs.load());
+    EXPECT_EQ(0, cancelledRuns.load());
+}